@@ -17,16 +17,24 @@
 #include "scritedocument.h"
 #include "garbagecollector.h"
 
+#include <QSet>
+#include <QCache>
+#include <QMutex>
 #include <QFuture>
 #include <QJsonObject>
+#include <QSharedPointer>
 #include <QTimerEvent>
 #include <QFutureWatcher>
+#include <QAtomicInt>
+#include <QThread>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QThreadStorage>
-#include <QtConcurrentRun>
+#include <QFutureInterface>
 #include <QRandomGenerator>
 #include <QCoreApplication>
 
-#include "3rdparty/sonnet/sonnet/src/core/speller.h"
+#include "3rdparty/sonnet/sonnet/src/core/spellerplugin_p.h"
 #include "3rdparty/sonnet/sonnet/src/core/loader_p.h"
 #include "3rdparty/sonnet/sonnet/src/core/textbreaks_p.h"
 #include "3rdparty/sonnet/sonnet/src/core/guesslanguage.h"
@@ -43,45 +51,299 @@ public:
     SpellCheckServiceResult() { padding[0] = 0; }
 
     int timestamp = -1;
+    int offset = 0;
     QString text;
+    int exemptionsRevision = -1;
+    int dictionaryRevision = -1;
     QList<TextFragment> misspelledFragments;
 };
 Q_DECLARE_METATYPE(SpellCheckServiceResult)
 
-class EnglishLanguageSpeller : public Sonnet::Speller
+static QString SpellCheckLanguage()
 {
-public:
 #ifdef Q_OS_MAC
-    EnglishLanguageSpeller() : Sonnet::Speller("en") { }
+    return QStringLiteral("en");
 #else
 #ifdef Q_OS_WIN
-    EnglishLanguageSpeller() : Sonnet::Speller() { }
+    return QString(); // default language
 #else
-    EnglishLanguageSpeller() : Sonnet::Speller("en_US") { }
+    return QStringLiteral("en_US");
 #endif
 #endif
-    ~EnglishLanguageSpeller() { }
+}
+
+/**
+ * Sonnet::Speller shares one speller plugin per language across all threads, but plugins
+ * (Hunspell in particular) are not safe for use from more than one thread at a time. So each
+ * spell-check thread creates its own plugin and keeps it around for as long as the thread
+ * lives.
+ *
+ * Words added to the personal dictionary are written to disk by the speller of the thread
+ * that adds them, one word at a time. Spellers on other threads pick them up into their
+ * session the next time they are used.
+ */
+class ThreadSpellers
+{
+public:
+    Sonnet::SpellerPlugin *speller();
+    bool addToPersonal(const QString &word);
+
+private:
+    struct ThreadSpeller
+    {
+        ~ThreadSpeller() { delete plugin; }
+
+        Sonnet::SpellerPlugin *plugin = nullptr;
+        int nrPersonalWords = 0;
+    };
+    void syncPersonalWords(ThreadSpeller *speller);
+
+private:
+    QMutex m_mutex;
+    QStringList m_personalWords;
+    QAtomicInt m_nrPersonalWords;
+    QThreadStorage<ThreadSpeller *> m_spellers;
 };
 
+Q_GLOBAL_STATIC(ThreadSpellers, TheThreadSpellers)
+
+Sonnet::SpellerPlugin *ThreadSpellers::speller()
+{
+    if (!m_spellers.hasLocalData()) {
+        ThreadSpeller *speller = new ThreadSpeller;
+
+        Sonnet::Loader *loader = Sonnet::Loader::openLoader();
+        if (loader != nullptr) {
+            QMutexLocker locker(&m_mutex);
+            speller->plugin = loader->createSpeller(::SpellCheckLanguage());
+        }
+
+        m_spellers.setLocalData(speller);
+    }
+
+    ThreadSpeller *speller = m_spellers.localData();
+    if (speller->plugin != nullptr
+        && speller->nrPersonalWords != m_nrPersonalWords.loadAcquire()) {
+        QMutexLocker locker(&m_mutex);
+        this->syncPersonalWords(speller);
+    }
+
+    return speller->plugin;
+}
+
+bool ThreadSpellers::addToPersonal(const QString &word)
+{
+    Sonnet::SpellerPlugin *plugin = this->speller();
+    if (plugin == nullptr)
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+
+    ThreadSpeller *speller = m_spellers.localData();
+    this->syncPersonalWords(speller);
+
+    if (!plugin->addToPersonal(word))
+        return false;
+
+    m_personalWords.append(word);
+    m_nrPersonalWords.storeRelease(m_personalWords.size());
+    speller->nrPersonalWords = m_personalWords.size();
+    return true;
+}
+
+void ThreadSpellers::syncPersonalWords(ThreadSpeller *speller)
+{
+    // Must be called with m_mutex locked.
+    while (speller->nrPersonalWords < m_personalWords.size())
+        speller->plugin->addToSession(m_personalWords.at(speller->nrPersonalWords++));
+}
+
+/**
+ * Spell-check verdicts of words, shared by all SpellCheckService instances, so that
+ * re-checking a paragraph only costs a dictionary lookup for words not seen before.
+ *
+ * Verdicts depend only on the dictionary. So the cache is cleared whenever a word is
+ * added to the personal dictionary. Character names and the ignore list are applied
+ * on top of cached verdicts for each request, so they don't affect the cache.
+ */
+class SpellCheckCache
+{
+public:
+    struct Verdict
+    {
+        bool misspelled = false;
+        bool hasSuggestions = false;
+        QStringList suggestions;
+    };
+
+    // Returns the generation of the cache, to be passed back to insert().
+    int find(const QString &word, Verdict *verdict, bool *found) const
+    {
+        QMutexLocker locker(&m_mutex);
+        const Verdict *cachedVerdict = m_verdicts.object(word);
+        *found = cachedVerdict != nullptr;
+        if (*found)
+            *verdict = *cachedVerdict;
+        return m_generation;
+    }
+
+    void insert(const QString &word, const Verdict &verdict, int generation)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // Verdicts looked up before the cache was last cleared may be stale.
+        if (generation == m_generation)
+            m_verdicts.insert(word, new Verdict(verdict));
+    }
+
+    void clear()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_verdicts.clear();
+        ++m_generation;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QCache<QString, Verdict> m_verdicts { 50000 };
+    int m_generation = 0;
+};
+
+Q_GLOBAL_STATIC(SpellCheckCache, TheSpellCheckCache)
+
+static SpellCheckCache::Verdict CheckWord(const QString &word, bool needSuggestions)
+{
+    SpellCheckCache::Verdict verdict;
+    bool found = false;
+    const int generation = ::TheSpellCheckCache()->find(word, &verdict, &found);
+    if (found && (!needSuggestions || !verdict.misspelled || verdict.hasSuggestions))
+        return verdict;
+
+    Sonnet::SpellerPlugin *speller = ::TheThreadSpellers()->speller();
+    if (speller == nullptr)
+        return verdict;
+
+    if (!found)
+        verdict.misspelled = speller->isMisspelled(word);
+    if (needSuggestions && verdict.misspelled) {
+        verdict.suggestions = speller->suggest(word);
+        verdict.hasSuggestions = true;
+    }
+
+    ::TheSpellCheckCache()->insert(word, verdict, generation);
+    return verdict;
+}
+
+/**
+ * Words that are not flagged as misspelled even if the dictionary doesn't know them: names
+ * of characters in the screenplay and words in the document's spell-check ignore list.
+ *
+ * One immutable set is shared by all requests, and built again only after character names
+ * or the ignore list change. Character names match regardless of case, so they are stored
+ * case-folded.
+ */
+class SpellCheckExemptions
+{
+public:
+    SpellCheckExemptions(int revision, const QStringList &characterNames,
+                         const QStringList &ignoreList);
+    ~SpellCheckExemptions() { }
+
+    int revision() const { return m_revision; }
+    bool contains(const QString &word) const;
+
+private:
+    int m_revision = 0;
+    QSet<QString> m_ignoreList;
+    QSet<QString> m_characterNames;
+};
+
+typedef QSharedPointer<const SpellCheckExemptions> SpellCheckExemptionsPtr;
+
+SpellCheckExemptions::SpellCheckExemptions(int revision, const QStringList &characterNames,
+                                           const QStringList &ignoreList)
+    : m_revision(revision), m_ignoreList(ignoreList.begin(), ignoreList.end())
+{
+    m_characterNames.reserve(characterNames.size() + 1);
+    for (const QString &name : characterNames)
+        m_characterNames.insert(name.toCaseFolded());
+    m_characterNames.insert(QStringLiteral("Rajkumar").toCaseFolded());
+}
+
+bool SpellCheckExemptions::contains(const QString &word) const
+{
+    if (m_ignoreList.contains(word))
+        return true;
+
+    const QString foldedWord = word.toCaseFolded();
+    if (m_characterNames.contains(foldedWord))
+        return true;
+
+    if (foldedWord.endsWith(QStringLiteral("\'s")))
+        return m_characterNames.contains(foldedWord.left(foldedWord.length() - 2));
+
+    return false;
+}
+
+static SpellCheckExemptionsPtr CurrentSpellCheckExemptions()
+{
+    // Must be called from the main thread only.
+    static bool initialized = false;
+    static int revision = 0;
+    static SpellCheckExemptionsPtr exemptions;
+    static QMetaObject::Connection characterNamesConnection;
+
+    ScriteDocument *document = ScriteDocument::instance();
+    if (!initialized) {
+        auto trackStructure = [document]() {
+            exemptions.reset();
+            QObject::disconnect(characterNamesConnection);
+            if (document->structure() != nullptr)
+                characterNamesConnection =
+                        QObject::connect(document->structure(), &Structure::characterNamesChanged,
+                                         document, []() { exemptions.reset(); });
+        };
+        QObject::connect(document, &ScriteDocument::structureChanged, document, trackStructure);
+        QObject::connect(document, &ScriteDocument::spellCheckIgnoreListChanged, document,
+                         []() { exemptions.reset(); });
+        trackStructure();
+        initialized = true;
+    }
+
+    if (exemptions.isNull()) {
+        const QStringList characterNames = document->structure() != nullptr
+                ? document->structure()->characterNames()
+                : QStringList();
+        exemptions.reset(new SpellCheckExemptions(++revision, characterNames,
+                                                  document->spellCheckIgnoreList()));
+    }
+
+    return exemptions;
+}
+
 struct SpellCheckServiceRequest
 {
-    QString text;
+    QString text; // only the span of text that needs checking
+    int offset = 0; // of the span within the whole text
     int timestamp;
-    QStringList characterNames;
-    QStringList ignoreList;
+    int dictionaryRevision;
+    SpellCheckExemptionsPtr exemptions;
 };
 Q_DECLARE_METATYPE(SpellCheckServiceRequest)
 
-void InitializeSpellCheckThread()
+bool InitializeSpellCheckThreads()
 {
-    Sonnet::Loader::openLoader();
+    return Sonnet::Loader::openLoader() != nullptr;
 }
 
 SpellCheckServiceResult CheckSpellings(const SpellCheckServiceRequest &request)
 {
     SpellCheckServiceResult result;
     result.timestamp = request.timestamp;
+    result.offset = request.offset;
     result.text = request.text;
+    result.exemptionsRevision = request.exemptions->revision();
+    result.dictionaryRevision = request.dictionaryRevision;
 
     if (request.text.isEmpty())
         return result; // Should never happen
@@ -106,10 +368,9 @@ SpellCheckServiceResult CheckSpellings(const SpellCheckServiceRequest &request)
      * Note and StructureElement also. This fits into the whole model-view thinking that
      * QML apps are required to leverage.
      *
-     * There is obviously room for improvement in this implementation. We could cache
-     * spell-check done in the previous round and only check for delta changes in here.
-     * But for now, we simply take a brute-force approach. But this function could be a
-     * good place for us to accept community contribution.
+     * Verdicts of words are cached across all paragraphs (see SpellCheckCache). So
+     * after an edit, only new words have to be looked up in the dictionary. Besides,
+     * SpellCheckService only sends us words touched by edits since the last check.
      */
 
     const Sonnet::TextBreaks::Positions wordPositions =
@@ -117,7 +378,6 @@ SpellCheckServiceResult CheckSpellings(const SpellCheckServiceRequest &request)
     if (wordPositions.isEmpty() || Sonnet::Loader::openLoader() == nullptr)
         return result;
 
-    EnglishLanguageSpeller speller;
     for (const Sonnet::TextBreaks::Position &wordPosition : wordPositions) {
         const QString word = request.text.mid(wordPosition.start, wordPosition.length);
         if (word.isEmpty())
@@ -136,22 +396,12 @@ SpellCheckServiceResult CheckSpellings(const SpellCheckServiceRequest &request)
             break;
         }
 
-        const bool misspelled = speller.isMisspelled(word);
+        const bool misspelled = CheckWord(word, false).misspelled;
         if (misspelled) {
-            if (request.ignoreList.contains(word))
+            if (request.exemptions->contains(word))
                 continue;
 
-            if (request.characterNames.contains(word, Qt::CaseInsensitive))
-                continue;
-
-            if (word.endsWith("\'s", Qt::CaseInsensitive)) {
-                if (request.characterNames.contains(word.leftRef(word.length() - 2),
-                                                    Qt::CaseInsensitive))
-                    continue;
-            }
-
-            const QStringList suggestions = speller.suggest(word);
-            TextFragment fragment(wordPosition.start, wordPosition.length, suggestions);
+            TextFragment fragment(request.offset + wordPosition.start, wordPosition.length);
             if (fragment.isValid())
                 result.misspelledFragments << fragment;
         }
@@ -165,8 +415,9 @@ bool AddToDictionary(const QString &word)
     /**
      * It is assumed that word contains a single word. We won't bother checking for that.
      */
-    EnglishLanguageSpeller speller;
-    return speller.addToPersonal(word);
+    const bool ret = ::TheThreadSpellers()->addToPersonal(word);
+    ::TheSpellCheckCache()->clear();
+    return ret;
 }
 
 QStringList GetSpellingSuggestions(const QString &word)
@@ -174,16 +425,56 @@ QStringList GetSpellingSuggestions(const QString &word)
     /**
      * It is assumed that word contains a single word. We won't bother checking for that.
      */
-    EnglishLanguageSpeller speller;
-    return speller.suggest(word);
+    return CheckWord(word, true).suggestions;
 }
 
+/**
+ * QtConcurrent::run() cannot pass a priority to the thread pool. We need one, so that
+ * paragraphs visible on screen are checked before the rest of the document, and so that
+ * suggestions and dictionary updates the user is waiting on jump the queue.
+ */
+enum SpellCheckTaskPriority {
+    LowTaskPriority = SpellCheckService::LowPriority,
+    NormalTaskPriority = SpellCheckService::NormalPriority,
+    HighTaskPriority = SpellCheckService::HighPriority,
+    InteractiveTaskPriority
+};
+
+template <typename T> class SpellCheckTask : public QRunnable
+{
+public:
+    static QFuture<T> start(QThreadPool *threadPool, int priority,
+                            const std::function<T()> &function)
+    {
+        SpellCheckTask<T> *task = new SpellCheckTask<T>(function);
+        task->m_futureInterface.reportStarted();
+
+        const QFuture<T> future = task->m_futureInterface.future();
+        threadPool->start(task, priority);
+        return future;
+    }
+
+    void run()
+    {
+        if (!m_futureInterface.isCanceled())
+            m_futureInterface.reportResult(m_function());
+        m_futureInterface.reportFinished();
+    }
+
+private:
+    SpellCheckTask(const std::function<T()> &function) : m_function(function) { }
+
+private:
+    QFutureInterface<T> m_futureInterface;
+    std::function<T()> m_function;
+};
+
 static QThreadPool *SpellCheckServiceThreadPool()
 {
     /**
-     * We make use of QtConcurrent::run() method to schedule the following methods on a
-     * background thread, so that they dont block the UI.
-     * - InitializeSpellCheckThread
+     * We schedule the following methods on background threads, so that they dont block
+     * the UI.
+     * - InitializeSpellCheckThreads
      * - CheckSpellings
      * - AddToDictionary
      * - GetSpellingSuggestions
@@ -193,9 +484,12 @@ static QThreadPool *SpellCheckServiceThreadPool()
      * to looup spellings asynchronously and in the background. So, scheduling these
      * functions in a background thread works for us.
      *
-     * Moreover we need exactly one thread for this purpose. While a QThreadPool can
-     * allocate multiple threads for us, we need only one. And one that thread is created
-     * it should NEVER EVER terminate until the program finishes.
+     * Opening a large document queues one request for every paragraph, note and index card.
+     * So we spread requests across a few threads, each with its own speller. Threads are
+     * never expired, because creating a speller means loading dictionaries all over again.
+     *
+     * On macOS all spellers talk to the one shared NSSpellChecker, so we stick to a single
+     * thread there.
      */
     static bool initialized = false;
     static QThreadPool threadPool;
@@ -203,10 +497,13 @@ static QThreadPool *SpellCheckServiceThreadPool()
 #ifdef Q_OS_MAC
         // Lookup documentation of this function to see why we are doing this.
         NSSpellCheckerClient::ensureSpellCheckerAvailability();
+        threadPool.setMaxThreadCount(1);
+#else
+        threadPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
 #endif
         threadPool.setExpiryTimeout(-1);
-        threadPool.setMaxThreadCount(1);
-        QFuture<void> future = QtConcurrent::run(&threadPool, InitializeSpellCheckThread);
+        QFuture<bool> future = SpellCheckTask<bool>::start(&threadPool, InteractiveTaskPriority,
+                                                           InitializeSpellCheckThreads);
         future.waitForFinished();
         initialized = true;
     }
@@ -214,6 +511,14 @@ static QThreadPool *SpellCheckServiceThreadPool()
     return &threadPool;
 }
 
+static int &SpellCheckDictionaryRevision()
+{
+    // Bumped whenever a word is added to the personal dictionary, so that services know
+    // to check all of their text again.
+    static int revision = 0;
+    return revision;
+}
+
 SpellCheckService::SpellCheckService(QObject *parent)
     : QObject(parent), m_textTracker(&m_textModifiable)
 {
@@ -226,9 +531,13 @@ void SpellCheckService::setText(const QString &val)
     if (m_text == val)
         return;
 
+    const QString oldText = m_text;
+
     m_text = val;
     m_textModifiable.markAsModified();
 
+    this->trackEdit(oldText);
+
     emit textChanged();
 
     this->doUpdate();
@@ -243,6 +552,15 @@ void SpellCheckService::setMethod(SpellCheckService::Method val)
     emit methodChanged();
 }
 
+void SpellCheckService::setPriority(Priority val)
+{
+    if (m_priority == val)
+        return;
+
+    m_priority = val;
+    emit priorityChanged();
+}
+
 void SpellCheckService::setAsynchronous(bool val)
 {
     if (m_asynchronous == val)
@@ -274,10 +592,25 @@ void SpellCheckService::update()
 
     emit started();
 
-    this->setMisspelledFragments(QList<TextFragment>());
-
     QThreadPool *threadPool = SpellCheckServiceThreadPool();
     if (threadPool == nullptr || m_text.isEmpty()) {
+        m_uncheckedStart = m_uncheckedEnd = 0;
+        this->setMisspelledFragments(QList<TextFragment>());
+        emit finished();
+        return;
+    }
+
+    const SpellCheckExemptionsPtr exemptions = ::CurrentSpellCheckExemptions();
+
+    // Words outside the span of text edited since the last check keep their verdicts, unless
+    // something that affects verdicts has changed since.
+    if (m_checkedDictionaryRevision != ::SpellCheckDictionaryRevision()
+        || m_checkedExemptionsRevision != exemptions->revision()) {
+        m_uncheckedStart = 0;
+        m_uncheckedEnd = m_text.length();
+    }
+
+    if (m_uncheckedStart >= m_uncheckedEnd) {
         emit finished();
         return;
     }
@@ -291,19 +624,18 @@ void SpellCheckService::update()
     Q_UNUSED(serviceRequestTypeId)
 
     SpellCheckServiceRequest request;
-    request.text = m_text;
+    request.text = m_text.mid(m_uncheckedStart, m_uncheckedEnd - m_uncheckedStart);
+    request.offset = m_uncheckedStart;
     request.timestamp = m_textModifiable.modificationTime();
-    request.characterNames = ScriteDocument::instance()->structure()->characterNames();
-    request.ignoreList = ScriteDocument::instance()->spellCheckIgnoreList();
-
-    request.characterNames << QStringLiteral("Rajkumar");
+    request.dictionaryRevision = ::SpellCheckDictionaryRevision();
+    request.exemptions = exemptions;
 
     QFutureWatcher<SpellCheckServiceResult> *watcher =
             new QFutureWatcher<SpellCheckServiceResult>(this);
     connect(watcher, SIGNAL(finished()), this, SLOT(spellCheckComplete()), Qt::QueuedConnection);
 
-    QFuture<SpellCheckServiceResult> future =
-            QtConcurrent::run(threadPool, CheckSpellings, request);
+    QFuture<SpellCheckServiceResult> future = SpellCheckTask<SpellCheckServiceResult>::start(
+            threadPool, m_priority, [request]() { return CheckSpellings(request); });
     watcher->setFuture(future);
 }
 
@@ -313,20 +645,65 @@ QStringList SpellCheckService::suggestions(const QString &word)
     if (threadPool == nullptr)
         return QStringList();
 
-    QFuture<QStringList> future = QtConcurrent::run(threadPool, GetSpellingSuggestions, word);
+    QFuture<QStringList> future = SpellCheckTask<QStringList>::start(
+            threadPool, InteractiveTaskPriority, [word]() { return GetSpellingSuggestions(word); });
     future.waitForFinished();
     return future.result();
 }
 
+bool SpellCheckService::cachedSuggestions(const QString &word, QStringList *suggestions)
+{
+    SpellCheckCache::Verdict verdict;
+    bool found = false;
+    ::TheSpellCheckCache()->find(word, &verdict, &found);
+    if (!found || (verdict.misspelled && !verdict.hasSuggestions))
+        return false;
+
+    if (suggestions)
+        *suggestions = verdict.suggestions;
+    return true;
+}
+
+void SpellCheckService::requestSuggestions(const QString &word, QObject *context,
+                                           const std::function<void(const QStringList &)> &callback)
+{
+    QStringList ret;
+    if (SpellCheckService::cachedSuggestions(word, &ret)) {
+        callback(ret);
+        return;
+    }
+
+    QThreadPool *threadPool = SpellCheckServiceThreadPool();
+    if (threadPool == nullptr) {
+        callback(ret);
+        return;
+    }
+
+    QFutureWatcher<QStringList> *watcher = new QFutureWatcher<QStringList>(context);
+    connect(watcher, &QFutureWatcher<QStringList>::finished, context, [=]() {
+        callback(watcher->result());
+        watcher->deleteLater();
+    });
+
+    QFuture<QStringList> future = SpellCheckTask<QStringList>::start(
+            threadPool, InteractiveTaskPriority, [word]() { return GetSpellingSuggestions(word); });
+    watcher->setFuture(future);
+}
+
 bool SpellCheckService::addToDictionary(const QString &word)
 {
     QThreadPool *threadPool = SpellCheckServiceThreadPool();
     if (threadPool == nullptr)
         return false;
 
-    QFuture<bool> future = QtConcurrent::run(threadPool, AddToDictionary, word);
+    QFuture<bool> future = SpellCheckTask<bool>::start(
+            threadPool, InteractiveTaskPriority, [word]() { return AddToDictionary(word); });
     future.waitForFinished();
-    return future.result();
+
+    const bool ret = future.result();
+    if (ret)
+        ++::SpellCheckDictionaryRevision();
+    return ret;
 }
 
 void SpellCheckService::classBegin() { }
@@ -392,8 +769,93 @@ void SpellCheckService::spellCheckComplete()
     this->acceptResult(result);
 }
 
+void SpellCheckService::trackEdit(const QString &oldText)
+{
+    // Find the span of text that changed, by skipping over what is common to the start
+    // and end of old and new text.
+    const int oldLength = oldText.length();
+    const int newLength = m_text.length();
+
+    int prefix = 0;
+    const int maxPrefix = qMin(oldLength, newLength);
+    while (prefix < maxPrefix && oldText.at(prefix) == m_text.at(prefix))
+        ++prefix;
+
+    int suffix = 0;
+    const int maxSuffix = maxPrefix - prefix;
+    while (suffix < maxSuffix
+           && oldText.at(oldLength - suffix - 1) == m_text.at(newLength - suffix - 1))
+        ++suffix;
+
+    // Grow the span to whole words, because words partly edited need to be checked again.
+    int start = prefix;
+    while (start > 0 && !m_text.at(start - 1).isSpace())
+        --start;
+
+    int end = newLength - suffix;
+    while (end < newLength && !m_text.at(end).isSpace())
+        ++end;
+
+    const int delta = newLength - oldLength;
+    const int oldEnd = end - delta;
+
+    // Misspelled words before the span stay where they are, those after it shift along
+    // with the text and those within it are dropped until the span is checked.
+    QList<TextFragment> fragments;
+    fragments.reserve(m_misspelledFragments.size());
+    for (const TextFragment &fragment : qAsConst(m_misspelledFragments)) {
+        if (fragment.end() < start)
+            fragments << fragment;
+        else if (fragment.start() >= oldEnd)
+            fragments << TextFragment(fragment.start() + delta, fragment.length());
+    }
+
+    // Any span still waiting to be checked moves along with the text too.
+    if (m_uncheckedStart < m_uncheckedEnd) {
+        auto mapPosition = [=](int position, int clampTo) {
+            if (position <= start)
+                return position;
+            return position >= oldEnd ? position + delta : clampTo;
+        };
+        const int uncheckedStart = mapPosition(m_uncheckedStart, start);
+        const int uncheckedEnd = mapPosition(m_uncheckedEnd, end);
+        m_uncheckedStart = qMin(start, uncheckedStart);
+        m_uncheckedEnd = qMin(qMax(end, uncheckedEnd), newLength);
+    } else {
+        m_uncheckedStart = start;
+        m_uncheckedEnd = end;
+    }
+
+    this->setMisspelledFragments(fragments);
+}
+
 void SpellCheckService::acceptResult(const SpellCheckServiceResult &result)
 {
-    this->setMisspelledFragments(result.misspelledFragments);
+    // The result has verdicts only for the span of text sent for checking.
+    const int start = result.offset;
+    const int end = result.offset + result.text.length();
+
+    QList<TextFragment> fragments;
+    fragments.reserve(m_misspelledFragments.size() + result.misspelledFragments.size());
+
+    auto it = m_misspelledFragments.constBegin();
+    auto last = m_misspelledFragments.constEnd();
+    for (; it != last && it->start() < start; ++it) {
+        if (it->end() < start)
+            fragments << *it;
+    }
+
+    fragments += result.misspelledFragments;
+
+    for (; it != last; ++it) {
+        if (it->start() >= end)
+            fragments << *it;
+    }
+
+    m_uncheckedStart = m_uncheckedEnd = 0;
+    m_checkedExemptionsRevision = result.exemptionsRevision;
+    m_checkedDictionaryRevision = result.dictionaryRevision;
+
+    this->setMisspelledFragments(fragments);
     emit finished();
 }
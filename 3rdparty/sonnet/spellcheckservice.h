@@ -19,20 +19,16 @@
 #include <QJsonArray>
 #include <QQmlParserStatus>
 
+#include <functional>
+
 #include "modifiable.h"
 #include "execlatertimer.h"
 
 struct TextFragment
 {
     TextFragment() { }
-    TextFragment(const TextFragment &other)
-        : m_start(other.m_start), m_length(other.m_length), m_suggestions(other.m_suggestions)
-    {
-    }
-    TextFragment(int s, int l, const QStringList &slist)
-        : m_start(s), m_length(l), m_suggestions(slist)
-    {
-    }
+    TextFragment(const TextFragment &other) : m_start(other.m_start), m_length(other.m_length) { }
+    TextFragment(int s, int l) : m_start(s), m_length(l) { }
 
     int start() const { return m_start; }
     int length() const { return m_length; }
@@ -40,22 +36,18 @@ struct TextFragment
     bool isValid() const { return m_length > 0 && m_start >= 0; }
     bool operator==(const TextFragment &other) const
     {
-        return m_start == other.m_start && m_length == other.m_length
-                && m_suggestions == other.m_suggestions;
+        return m_start == other.m_start && m_length == other.m_length;
     }
     TextFragment &operator=(const TextFragment &other)
     {
         m_start = other.m_start;
         m_length = other.m_length;
-        m_suggestions = other.m_suggestions;
         return *this;
     }
-    QStringList suggestions() const { return m_suggestions; }
 
 private:
     int m_start = -1;
     int m_length = 0;
-    QStringList m_suggestions;
 };
 Q_DECLARE_METATYPE(TextFragment)
 
@@ -98,10 +90,25 @@ public:
     bool isAsynchronous() const { return m_asynchronous; }
     Q_SIGNAL void asynchronousChanged();
 
+    // Requests of services with higher priority are picked up first by spell-check threads.
+    // Views set HighPriority on text visible on screen.
+    enum Priority { LowPriority, NormalPriority, HighPriority };
+    Q_ENUM(Priority)
+    Q_PROPERTY(Priority priority READ priority WRITE setPriority NOTIFY priorityChanged)
+    void setPriority(Priority val);
+    Priority priority() const { return m_priority; }
+    Q_SIGNAL void priorityChanged();
+
     Q_INVOKABLE void scheduleUpdate();
     Q_INVOKABLE void update();
 
+    // Spell-check only finds misspelled words. Suggestions cost a lot more than checking,
+    // so they are looked up only when asked for, and cached.
     static QStringList suggestions(const QString &word);
+    static bool cachedSuggestions(const QString &word, QStringList *suggestions);
+    static void requestSuggestions(const QString &word, QObject *context,
+                                   const std::function<void(const QStringList &)> &callback);
+
     static bool addToDictionary(const QString &word);
 
     // QQmlParserStatus interface
@@ -114,6 +121,7 @@ signals:
 
 private:
     void setMisspelledFragments(const QList<TextFragment> &val);
+    void trackEdit(const QString &oldText);
     void doUpdate();
     void timerEvent(QTimerEvent *event);
     Q_SLOT void spellCheckComplete();
@@ -123,12 +131,19 @@ private:
     QString m_text;
     Method m_method = OnDemand;
     bool m_asynchronous = true;
+    Priority m_priority = NormalPriority;
     bool m_requiresSpellCheck = false;
     ExecLaterTimer m_updateTimer;
     Modifiable m_textModifiable;
     ModificationTracker m_textTracker;
     QJsonArray m_misspelledFragmentsJson;
     QList<TextFragment> m_misspelledFragments;
+
+    // Span of m_text edited since the last check, and what the last check was done with.
+    int m_uncheckedStart = 0;
+    int m_uncheckedEnd = 0;
+    int m_checkedExemptionsRevision = -1;
+    int m_checkedDictionaryRevision = -1;
 };
 
 #endif // SPELL_CHECK_SERVICE_H
@@ -125,7 +125,7 @@ Item {
                 Text {
                     text: {
                         if(searchEngine.searchResultCount > 0)
-                            return "  " +  (searchEngine.currentSearchResultIndex+1) + "/" + searchEngine.searchResultCount + "  "
+                            return "  " +  (searchEngine.currentSearchResultIndex+1) + "/" + searchEngine.searchResultCount + (searchEngine.searching ? "+" : "") + "  "
                         return ""
                     }
                     anchors.verticalCenter: parent.verticalCenter
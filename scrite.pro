@@ -67,6 +67,8 @@ HEADERS += \
     src/document/form.h \
     src/document/notebookmodel.h \
     src/document/notes.h \
+    src/document/screenplaysearchindex.h \
+    src/document/screenplaylayoutmetrics.h \
     src/document/screenplaytextdocumentoffsets.h \
     src/document/scritedocumentvault.h \
     src/exporters/characterrelationshipsgraphexporter.h \
@@ -77,6 +79,7 @@ HEADERS += \
     src/network/networkaccessmanager.h \
     src/network/user.h \
     src/printing/qtextdocumentpagedprinter.h \
+    src/printing/qtextdocumentpagerecorder.h \
     src/quick/items/boundingboxevaluator.h \
     src/quick/items/simpletabbaritem.h \
     src/quick/items/textdocumentitem.h \
@@ -134,6 +137,7 @@ HEADERS += \
     src/document/transliteration.h \
     src/document/scritedocument.h \
     src/document/documentfilesystem.h \
+    src/document/documentheadercodec.h \
     src/document/structure.h \
     src/document/screenplaytextdocument.h \
     src/document/undoredo.h \
@@ -195,6 +199,8 @@ SOURCES += \
     src/document/form.cpp \
     src/document/notebookmodel.cpp \
     src/document/notes.cpp \
+    src/document/screenplaysearchindex.cpp \
+    src/document/screenplaylayoutmetrics.cpp \
     src/document/screenplaytextdocumentoffsets.cpp \
     src/document/scritedocumentvault.cpp \
     src/exporters/characterrelationshipsgraphexporter.cpp \
@@ -205,6 +211,7 @@ SOURCES += \
     src/network/networkaccessmanager.cpp \
     src/network/user.cpp \
     src/printing/qtextdocumentpagedprinter.cpp \
+    src/printing/qtextdocumentpagerecorder.cpp \
     src/quick/items/boundingboxevaluator.cpp \
     src/quick/items/simpletabbaritem.cpp \
     src/quick/items/textdocumentitem.cpp \
@@ -259,6 +266,7 @@ SOURCES += \
     src/document/screenplay.cpp \
     src/document/scene.cpp \
     src/document/documentfilesystem.cpp \
+    src/document/documentheadercodec.cpp \
     src/document/structure.cpp \
     src/document/screenplaytextdocument.cpp \
     src/document/undoredo.cpp \
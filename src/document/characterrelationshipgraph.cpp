@@ -29,8 +29,10 @@
 #include <QFontMetrics>
 #include <QElapsedTimer>
 #include <QFutureWatcher>
+#include <QScopedPointer>
 #include <QStandardPaths>
 #include <QtConcurrentRun>
+#include <QVariantAnimation>
 
 CharacterRelationshipGraphNode::CharacterRelationshipGraphNode(QObject *parent)
     : QObject(parent), m_item(this, "item"), m_character(this, "character")
@@ -394,6 +396,24 @@ void CharacterRelationshipGraph::setMaxIterations(int val)
     emit maxIterationsChanged();
 }
 
+void CharacterRelationshipGraph::setLayoutEngine(LayoutEngine val)
+{
+    if (m_layoutEngine == val)
+        return;
+
+    m_layoutEngine = val;
+    emit layoutEngineChanged();
+}
+
+void CharacterRelationshipGraph::setIncrementalLayout(bool val)
+{
+    if (m_incrementalLayout == val)
+        return;
+
+    m_incrementalLayout = val;
+    emit incrementalLayoutChanged();
+}
+
 void CharacterRelationshipGraph::setLeftMargin(qreal val)
 {
     if (qFuzzyCompare(m_leftMargin, val))
@@ -553,11 +573,37 @@ void CharacterRelationshipGraph::resetCharacter()
     emit characterChanged();
 }
 
+static QRectF savedNodeRect(const QJsonObject &graphJson, const Character *character)
+{
+    const QJsonValue rectJsonValue = graphJson.value(character->name());
+    if (rectJsonValue.isUndefined() || !rectJsonValue.isObject())
+        return QRectF();
+
+    const QJsonObject rectJson = rectJsonValue.toObject();
+    return QRectF(rectJson.value("x").toDouble(), rectJson.value("y").toDouble(),
+                  rectJson.value("width").toDouble(), rectJson.value("height").toDouble());
+}
+
 void CharacterRelationshipGraph::load()
 {
     HourGlass hourGlass;
     this->setBusy(true);
 
+    // Incremental layouts still running are about nodes that are going away.
+    typedef QFutureWatcher<GraphLayout::IncrementalLayout::Snapshot> IncrementalLayoutWatcher;
+    const QList<IncrementalLayoutWatcher *> watchers =
+            this->findChildren<IncrementalLayoutWatcher *>(
+                    QStringLiteral("incrementalLayoutFuture"), Qt::FindDirectChildrenOnly);
+    for (IncrementalLayoutWatcher *watcher : watchers) {
+        watcher->cancel();
+        watcher->deleteLater();
+    }
+
+    const QList<QVariantAnimation *> animations = this->findChildren<QVariantAnimation *>(
+            QStringLiteral("nodePlacementAnimation"), Qt::FindDirectChildrenOnly);
+    for (QVariantAnimation *animation : animations)
+        animation->stop();
+
     QList<CharacterRelationshipGraphEdge *> edges = m_edges.list();
     m_edges.clear();
     for (CharacterRelationshipGraphEdge *edge : qAsConst(edges)) {
@@ -741,6 +787,9 @@ void CharacterRelationshipGraph::load()
         if (graph.nodes.isEmpty())
             continue;
 
+        // Graphs laid out incrementally stay where they were laid out before.
+        bool keepInPlace = false;
+
         if (i >= 1) {
             QString longestRelationshipName;
             for (GraphLayout::AbstractEdge *agedge : qAsConst(graph.edges)) {
@@ -753,12 +802,23 @@ void CharacterRelationshipGraph::load()
             }
 
             const QFontMetricsF fm(qApp->font());
-
-            GraphLayout::ForceDirectedLayout layout;
-            layout.setMaxTime(m_maxTime);
-            layout.setMaxIterations(m_maxIterations);
-            layout.setMinimumEdgeLength(fm.horizontalAdvance(longestRelationshipName) * 0.5);
-            layout.layout(graph);
+            const qreal minimumEdgeLength = fm.horizontalAdvance(longestRelationshipName) * 0.5;
+
+            if (m_incrementalLayout)
+                keepInPlace =
+                        this->layoutIncrementally(graph, previousGraphJson, minimumEdgeLength);
+
+            if (!keepInPlace) {
+                QScopedPointer<GraphLayout::AbstractLayout> layout;
+                if (m_layoutEngine == BarnesHutLayoutEngine)
+                    layout.reset(new GraphLayout::BarnesHutLayout);
+                else
+                    layout.reset(new GraphLayout::ForceDirectedLayout);
+                layout->setMaxTime(m_maxTime);
+                layout->setMaxIterations(m_maxIterations);
+                layout->setMinimumEdgeLength(minimumEdgeLength);
+                layout->layout(graph);
+            }
         }
 
         // Compute bounding rect of the nodes.
@@ -769,23 +829,18 @@ void CharacterRelationshipGraph::load()
 
             const Character *character = gnode->character();
 
-            const QJsonValue rectJsonValue = previousGraphJson.value(character->name());
-            if (!rectJsonValue.isUndefined() && rectJsonValue.isObject()) {
-                const QJsonObject rectJson = rectJsonValue.toObject();
-                const QRectF rect(rectJson.value("x").toDouble(), rectJson.value("y").toDouble(),
-                                  rectJson.value("width").toDouble(),
-                                  rectJson.value("height").toDouble());
-                if (rect.isValid()) {
-                    gnode->setRect(rect);
-                    gnode->m_placedByUser = true;
-                }
+            const QRectF rect = ::savedNodeRect(previousGraphJson, character);
+            if (rect.isValid()) {
+                gnode->setRect(rect);
+                gnode->m_placedByUser = true;
             }
 
             graphRect |= gnode->rect();
         }
 
         // Move the nodes such that they are layed out in a row.
-        const QPointF dp = -graphRect.topLeft() + boundingRect.topRight();
+        const QPointF dp =
+                keepInPlace ? QPointF(0, 0) : -graphRect.topLeft() + boundingRect.topRight();
         for (GraphLayout::AbstractNode *agnode : qAsConst(graph.nodes)) {
             CharacterRelationshipGraphNode *gnode =
                     qobject_cast<CharacterRelationshipGraphNode *>(agnode->containerObject());
@@ -832,6 +887,124 @@ void CharacterRelationshipGraph::loadLater()
     m_loadTimer.start(0, this);
 }
 
+bool CharacterRelationshipGraph::layoutIncrementally(const GraphLayout::Graph &graph,
+                                                     const QJsonObject &previousGraphJson,
+                                                     qreal minimumEdgeLength)
+{
+    // Only graphs with nodes placed before are laid out incrementally. Those nodes are
+    // pinned where they were, and only nodes added since are placed around them.
+    int nrPlacedNodes = 0;
+    for (GraphLayout::AbstractNode *agnode : qAsConst(graph.nodes)) {
+        CharacterRelationshipGraphNode *gnode =
+                qobject_cast<CharacterRelationshipGraphNode *>(agnode->containerObject());
+        const QRectF rect = ::savedNodeRect(previousGraphJson, gnode->character());
+        if (!rect.isValid())
+            continue;
+
+        gnode->setRect(rect);
+        gnode->setPosition(rect.center());
+        gnode->m_placedByUser = true;
+        ++nrPlacedNodes;
+    }
+
+    if (nrPlacedNodes == 0)
+        return false;
+
+    if (nrPlacedNodes == graph.nodes.size())
+        return true;
+
+    // Iterations of full layouts are not meant for this, only the time limit is.
+    GraphLayout::IncrementalLayout layout;
+    layout.setMaxTime(m_maxTime);
+    layout.setMinimumEdgeLength(minimumEdgeLength);
+
+    GraphLayout::IncrementalLayout::Snapshot snapshot;
+    if (!layout.snapshot(graph, snapshot))
+        return false;
+
+    // New nodes show up next to their neighbours right away, and glide into place once they
+    // are laid out on a worker thread.
+    layout.seed(snapshot);
+
+    QList<QPointer<CharacterRelationshipGraphNode>> nodes;
+    for (int i = 0; i < graph.nodes.size(); i++) {
+        CharacterRelationshipGraphNode *gnode = qobject_cast<CharacterRelationshipGraphNode *>(
+                graph.nodes.at(i)->containerObject());
+        if (snapshot.movable.at(i))
+            gnode->setPosition(snapshot.positions.at(i));
+        nodes.append(gnode);
+    }
+
+    typedef QFutureWatcher<GraphLayout::IncrementalLayout::Snapshot> IncrementalLayoutWatcher;
+    IncrementalLayoutWatcher *futureWatcher = new IncrementalLayoutWatcher(this);
+    futureWatcher->setObjectName(QStringLiteral("incrementalLayoutFuture"));
+    connect(futureWatcher, &IncrementalLayoutWatcher::finished, this, [=]() {
+        futureWatcher->deleteLater();
+        if (futureWatcher->isCanceled())
+            return;
+
+        this->animateNodePlacement(nodes, futureWatcher->result());
+    });
+    futureWatcher->setFuture(QtConcurrent::run([layout, snapshot]() mutable {
+        layout.layout(snapshot);
+        return snapshot;
+    }));
+
+    return true;
+}
+
+void CharacterRelationshipGraph::animateNodePlacement(
+        const QList<QPointer<CharacterRelationshipGraphNode>> &nodes,
+        const GraphLayout::IncrementalLayout::Snapshot &snapshot)
+{
+    QList<QPointer<CharacterRelationshipGraphNode>> movedNodes;
+    QVector<QPointF> fromPositions, toPositions;
+    for (int i = 0; i < nodes.size() && i < snapshot.positions.size(); i++) {
+        if (!snapshot.movable.at(i) || nodes.at(i).isNull())
+            continue;
+
+        movedNodes.append(nodes.at(i));
+        fromPositions.append(nodes.at(i)->position());
+        toPositions.append(snapshot.positions.at(i));
+    }
+
+    if (movedNodes.isEmpty())
+        return;
+
+    // Only nodes that were added move, all others stay where they are.
+    QVariantAnimation *animation = new QVariantAnimation(this);
+    animation->setObjectName(QStringLiteral("nodePlacementAnimation"));
+    animation->setDuration(300);
+    animation->setEasingCurve(QEasingCurve::OutCubic);
+    animation->setStartValue(0.0);
+    animation->setEndValue(1.0);
+    connect(animation, &QVariantAnimation::valueChanged, this, [=](const QVariant &value) {
+        const qreal t = value.toReal();
+        for (int i = 0; i < movedNodes.size(); i++) {
+            if (!movedNodes.at(i).isNull())
+                movedNodes.at(i)->setPosition(fromPositions.at(i)
+                                              + (toPositions.at(i) - fromPositions.at(i)) * t);
+        }
+    });
+    connect(animation, &QVariantAnimation::finished, this, [=]() {
+        QRectF boundingRect = m_graphBoundingRect;
+        for (CharacterRelationshipGraphNode *node : movedNodes) {
+            if (node == nullptr)
+                continue;
+
+            // Nodes placed here are remembered just like those placed by the user, once
+            // the view has created items for them.
+            if (node->isPlacedByUser())
+                this->updateGraphJsonFromNode(node);
+
+            boundingRect |= node->rect().adjusted(0, 0, m_rightMargin, m_bottomMargin);
+        }
+
+        this->setGraphBoundingRect(boundingRect);
+    });
+    animation->start(QAbstractAnimation::DeleteWhenStopped);
+}
+
 void CharacterRelationshipGraph::evaluateTitle()
 {
     const QString defaultTitle = QStringLiteral("Character Relationship Graph");
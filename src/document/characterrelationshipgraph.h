@@ -215,6 +215,23 @@ public:
     int maxIterations() const { return m_maxIterations; }
     Q_SIGNAL void maxIterationsChanged();
 
+    enum LayoutEngine { ForceDirectedLayoutEngine, BarnesHutLayoutEngine };
+    Q_ENUM(LayoutEngine)
+
+    Q_PROPERTY(
+            LayoutEngine layoutEngine READ layoutEngine WRITE setLayoutEngine NOTIFY layoutEngineChanged)
+    void setLayoutEngine(LayoutEngine val);
+    LayoutEngine layoutEngine() const { return m_layoutEngine; }
+    Q_SIGNAL void layoutEngineChanged();
+
+    // When set, graphs that were laid out before are not laid out again from scratch. Nodes
+    // placed before stay where they are, and only nodes added since are placed around them.
+    Q_PROPERTY(bool incrementalLayout READ isIncrementalLayout WRITE setIncrementalLayout NOTIFY
+                       incrementalLayoutChanged)
+    void setIncrementalLayout(bool val);
+    bool isIncrementalLayout() const { return m_incrementalLayout; }
+    Q_SIGNAL void incrementalLayoutChanged();
+
     Q_PROPERTY(QRectF graphBoundingRect READ graphBoundingRect NOTIFY graphBoundingRectChanged)
     QRectF graphBoundingRect() const { return m_graphBoundingRect; }
     Q_SIGNAL void graphBoundingRectChanged();
@@ -274,6 +291,10 @@ private:
     void resetCharacter();
     void load();
     void loadLater();
+    bool layoutIncrementally(const GraphLayout::Graph &graph, const QJsonObject &previousGraphJson,
+                             qreal minimumEdgeLength);
+    void animateNodePlacement(const QList<QPointer<CharacterRelationshipGraphNode>> &nodes,
+                              const GraphLayout::IncrementalLayout::Snapshot &snapshot);
     void evaluateTitle();
     void markDirty() { this->setDirty(true); }
     void setDirty(bool val);
@@ -290,6 +311,8 @@ private:
     qreal m_rightMargin = 0;
     qreal m_bottomMargin = 0;
     int m_maxIterations = -1;
+    LayoutEngine m_layoutEngine = BarnesHutLayoutEngine;
+    bool m_incrementalLayout = true;
     QObjectProperty<Scene> m_scene;
     bool m_componentLoaded = false;
     QRectF m_graphBoundingRect = QRectF(0, 0, 500, 500);
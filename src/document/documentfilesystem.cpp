@@ -12,11 +12,15 @@
 ****************************************************************************/
 
 #include "documentfilesystem.h"
+#include "documentheadercodec.h"
 
 #include <QDir>
+#include <QSet>
+#include <QHash>
 #include <QtDebug>
 #include <QDateTime>
 #include <QDataStream>
+#include <QSaveFile>
 #include <QTemporaryDir>
 #include <QFutureWatcher>
 #include <QStandardPaths>
@@ -27,22 +31,84 @@
 #include "simplecrypt.h"
 #include "restapikey/restapikey.h"
 
+struct DocumentFileSystemEntryState
+{
+    qint64 size = -1;
+    QDateTime lastModified;
+
+    DocumentFileSystemEntryState() { }
+    DocumentFileSystemEntryState(const QFileInfo &fi)
+        : size(fi.size()), lastModified(fi.lastModified())
+    {
+    }
+
+    bool operator==(const DocumentFileSystemEntryState &other) const
+    {
+        return size == other.size && lastModified == other.lastModified;
+    }
+    bool operator!=(const DocumentFileSystemEntryState &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+typedef QHash<QString, DocumentFileSystemEntryState> DocumentFileSystemEntryStates;
+
 struct DocumentFileSystemData
 {
     QByteArray header;
+    DocumentFileSystem::HeaderFunction headerFunction;
     QList<DocumentFile *> files;
     QMutex folderMutex;
     QScopedPointer<QTemporaryDir> folder;
 
+    // Incremental save support. entryStates captures the state of files in folder
+    // (relative path to file-state) at the time they were last loaded from or saved
+    // into the archive at archiveFilePath. It is accessed only while folderMutex is
+    // locked. dirtyPaths is accessed only from the thread that owns the
+    // DocumentFileSystem.
+    bool incrementalSave = true;
+    DocumentFileSystemEntryStates entryStates;
+    QSet<QString> dirtyPaths;
+
+    // Lazy load support. Entries of the archive at archiveFilePath listed in
+    // pendingEntries have not yet been extracted into folder, they get extracted
+    // upon first access. These are accessed only while archiveMutex is locked, so
+    // that looking up paths doesn't have to wait for a non-blocking save to finish.
+    bool lazyLoad = true;
+    QMutex archiveMutex;
+    QString archiveFilePath;
+    QSet<QString> pendingEntries;
+    DocumentFileSystemEntryStates extractedStates;
+    QScopedPointer<QuaZip> lazyArchive;
+    QScopedPointer<QTemporaryDir> stagingFolder;
+
+    // Pending entries are carried over into the next archive from this handle, rather than
+    // from archiveFilePath, so that they survive the archive being moved or deleted before
+    // the document is saved. It is open only while there are pending entries, and is
+    // accessed only while folderMutex is locked.
+    QScopedPointer<QFile> archiveFile;
+
+    bool isPendingEntry(const QString &path);
+    bool discardPendingEntry(const QString &path);
+    bool extractPendingEntry(const QString &path);
+    void closeLazyArchive();
+    void updateArchiveFile();
+
     static const QString normalHeaderFile;
     static const QString encryptedHeaderFile;
 
     void pack(QDataStream &ds, const QString &path);
 
-    QStringList filePaths() const
+    QStringList filePaths()
     {
         QStringList ret;
         this->filePaths(ret, folder->path());
+
+        QMutexLocker archiveMutexLocker(&archiveMutex);
+        for (const QString &pendingEntry : qAsConst(pendingEntries))
+            if (!ret.contains(pendingEntry))
+                ret.append(pendingEntry);
         return ret;
     }
 
@@ -135,6 +201,19 @@ void DocumentFileSystem::hardReset()
 void DocumentFileSystem::reset()
 {
     d->header.clear();
+    d->headerFunction = nullptr;
+    d->entryStates.clear();
+    d->dirtyPaths.clear();
+
+    {
+        QMutexLocker archiveMutexLocker(&d->archiveMutex);
+        d->closeLazyArchive();
+        d->archiveFile.reset();
+        d->archiveFilePath.clear();
+        d->pendingEntries.clear();
+        d->extractedStates.clear();
+        d->stagingFolder.reset();
+    }
 
     while (!d->files.isEmpty()) {
         DocumentFile *file = d->files.first();
@@ -148,7 +227,40 @@ void DocumentFileSystem::reset()
 #endif
 }
 
-bool doUnzip(const QFileInfo &fileInfo, const QTemporaryDir &dstDir)
+bool doUnzipCurrentFile(QuaZip &qzip, const QString &dstFileName)
+{
+    const QFileInfo dstFileInfo(dstFileName);
+    QDir().mkpath(dstFileInfo.absolutePath());
+
+    QuaZipFile srcFile(&qzip);
+    if (!srcFile.open(QFile::ReadOnly)) {
+        qInfo("Could not open '%s' for reading.", qPrintable(qzip.getCurrentFileName()));
+        return false;
+    }
+
+    QFile dstFile(dstFileName);
+    if (!dstFile.open(QFile::WriteOnly)) {
+        qInfo("Could not open '%s' for writing.", qPrintable(dstFileName));
+        return false;
+    }
+
+    const int bufferLength = 65535;
+    char buffer[bufferLength];
+    while (!srcFile.atEnd()) {
+        const int nrBytes = srcFile.read(buffer, bufferLength);
+        dstFile.write(buffer, nrBytes);
+        if (nrBytes < bufferLength)
+            break;
+    }
+
+    dstFile.close();
+    srcFile.close();
+
+    return srcFile.getZipError() == UNZ_OK;
+}
+
+bool doUnzip(const QFileInfo &fileInfo, const QTemporaryDir &dstDir,
+             DocumentFileSystemEntryStates *entryStates = nullptr)
 {
     const QString zipFileName = fileInfo.absoluteFilePath();
 
@@ -166,43 +278,153 @@ bool doUnzip(const QFileInfo &fileInfo, const QTemporaryDir &dstDir)
         if (!qzip.getCurrentFileInfo(&qfileInfo))
             break;
 
-        const QFileInfo dstFileInfo = dstDir.filePath(qfileInfo.name);
-        const QString dstFileName = dstFileInfo.absoluteFilePath();
-        QDir().mkpath(dstFileInfo.absolutePath());
+        const QString dstFileName = QFileInfo(dstDir.filePath(qfileInfo.name)).absoluteFilePath();
+        if (doUnzipCurrentFile(qzip, dstFileName) && entryStates != nullptr)
+            entryStates->insert(qfileInfo.name, DocumentFileSystemEntryState(dstFileName));
 
-        QuaZipFile srcFile(&qzip);
-        if (!srcFile.open(QFile::ReadOnly)) {
-            qInfo("Could not open '%s' for reading.", qPrintable(qfileInfo.name));
-            qzip.goToNextFile();
-            continue;
-        }
+        qzip.goToNextFile();
+    }
+
+    qzip.close();
+
+    return true;
+}
+
+// Opens the ZIP file and reads its central directory. Only the header entry is
+// decompressed, names of all other entries are returned in pendingEntries.
+bool doLazyUnzip(QuaZip &qzip, QByteArray &headerData, bool &encrypted,
+                 QSet<QString> &pendingEntries)
+{
+    qzip.setUtf8Enabled(true);
+    if (!qzip.open(QuaZip::mdUnzip)) {
+        qInfo("Could not open %s", qPrintable(qzip.getZipName()));
+        return false;
+    }
+
+    const QStringList entryNames = qzip.getFileNameList();
+
+    QString headerEntry;
+    if (entryNames.contains(DocumentFileSystemData::normalHeaderFile))
+        headerEntry = DocumentFileSystemData::normalHeaderFile;
+    else if (entryNames.contains(DocumentFileSystemData::encryptedHeaderFile))
+        headerEntry = DocumentFileSystemData::encryptedHeaderFile;
+    else
+        return false;
+
+    if (!qzip.setCurrentFile(headerEntry, QuaZip::csSensitive))
+        return false;
 
-        QFile dstFile(dstFileName);
-        if (!dstFile.open(QFile::WriteOnly)) {
-            qInfo("Could not open '%s' for writing.", qPrintable(dstFileName));
-            qzip.goToNextFile();
+    QuaZipFile headerFile(&qzip);
+    if (!headerFile.open(QFile::ReadOnly))
+        return false;
+
+    headerData = headerFile.readAll();
+    headerFile.close();
+    encrypted = headerEntry == DocumentFileSystemData::encryptedHeaderFile;
+
+    // Header is written afresh on every save, so it is never pending.
+    for (const QString &entryName : entryNames) {
+        if (entryName == DocumentFileSystemData::normalHeaderFile
+            || entryName == DocumentFileSystemData::encryptedHeaderFile
+            || entryName.endsWith(QChar('/')))
             continue;
-        }
+        pendingEntries += entryName;
+    }
 
-        const int bufferLength = 65535;
-        char buffer[bufferLength];
-        while (!srcFile.atEnd()) {
-            const int nrBytes = srcFile.read(buffer, bufferLength);
-            dstFile.write(buffer, nrBytes);
-            if (nrBytes < bufferLength)
-                break;
+    return !headerData.isEmpty();
+}
+
+bool DocumentFileSystemData::isPendingEntry(const QString &path)
+{
+    QMutexLocker archiveMutexLocker(&archiveMutex);
+    return !pendingEntries.isEmpty() && pendingEntries.contains(QDir::cleanPath(path));
+}
+
+bool DocumentFileSystemData::discardPendingEntry(const QString &path)
+{
+    QMutexLocker archiveMutexLocker(&archiveMutex);
+    return !pendingEntries.isEmpty() && pendingEntries.remove(QDir::cleanPath(path));
+}
+
+bool DocumentFileSystemData::extractPendingEntry(const QString &path)
+{
+    QMutexLocker archiveMutexLocker(&archiveMutex);
+
+    if (pendingEntries.isEmpty())
+        return false;
+
+    const QString entryName = QDir::cleanPath(path);
+    if (!pendingEntries.contains(entryName))
+        return false;
+
+    pendingEntries.remove(entryName);
+
+    if (lazyArchive.isNull()) {
+        lazyArchive.reset(new QuaZip(archiveFilePath));
+        lazyArchive->setUtf8Enabled(true);
+        if (!lazyArchive->open(QuaZip::mdUnzip)) {
+            qInfo("Could not open %s", qPrintable(archiveFilePath));
+            lazyArchive.reset();
+            return false;
         }
+    }
 
-        dstFile.close();
-        srcFile.close();
-        qzip.goToNextFile();
+    if (!lazyArchive->setCurrentFile(entryName, QuaZip::csSensitive))
+        return false;
+
+    // A non-blocking save could be walking folder right now. So we extract into
+    // a staging folder first and then move the file into place, which ensures that
+    // the save either sees the whole file or doesn't see it at all.
+    if (stagingFolder.isNull())
+        stagingFolder.reset(new QTemporaryDir);
+
+    const QString stagedFileName = stagingFolder->filePath(QString::number(qHash(entryName)));
+    const QString dstFileName = folder->filePath(entryName);
+    if (!doUnzipCurrentFile(*lazyArchive, stagedFileName)) {
+        QFile::remove(stagedFileName);
+        return false;
     }
 
-    qzip.close();
+    QDir().mkpath(QFileInfo(dstFileName).absolutePath());
+    if (!QFile::rename(stagedFileName, dstFileName)) {
+        QFile::remove(stagedFileName);
+        return false;
+    }
 
+    // Extracted file is the same as what is in the archive, so incremental save
+    // can copy it back as-is. The next save merges this into entryStates; we cannot
+    // do that here, because a non-blocking save could be holding folderMutex.
+    extractedStates.insert(entryName, DocumentFileSystemEntryState(dstFileName));
     return true;
 }
 
+void DocumentFileSystemData::closeLazyArchive()
+{
+    if (!lazyArchive.isNull()) {
+        lazyArchive->close();
+        lazyArchive.reset();
+    }
+}
+
+void DocumentFileSystemData::updateArchiveFile()
+{
+    // Called while both folderMutex and archiveMutex are locked.
+    if (pendingEntries.isEmpty() || archiveFilePath.isEmpty()) {
+        archiveFile.reset();
+        return;
+    }
+
+    if (!archiveFile.isNull() && archiveFile->fileName() == archiveFilePath
+        && archiveFile->isOpen())
+        return;
+
+    archiveFile.reset(new QFile(archiveFilePath));
+    if (!archiveFile->open(QFile::ReadOnly)) {
+        qInfo("Could not open %s", qPrintable(archiveFilePath));
+        archiveFile.reset();
+    }
+}
+
 bool DocumentFileSystem::load(const QString &fileName, Format *format)
 {
     QMutexLocker mutexLocker(&d->folderMutex);
@@ -232,7 +454,36 @@ bool DocumentFileSystem::load(const QString &fileName, Format *format)
     // document as a ZIP file.
     file.close();
 
-    if (doUnzip(QFileInfo(fileName), *d->folder)) {
+    const QString zipFileName = QFileInfo(fileName).absoluteFilePath();
+
+    if (d->lazyLoad) {
+        QByteArray headerData;
+        bool encrypted = false;
+        QSet<QString> pendingEntries;
+
+        QScopedPointer<QuaZip> qzip(new QuaZip(zipFileName));
+        if (!doLazyUnzip(*qzip, headerData, encrypted, pendingEntries))
+            return false;
+
+        if (encrypted) {
+            SimpleCrypt sc(REST_CRYPT_KEY);
+            d->header = sc.decryptToByteArray(headerData);
+        } else
+            d->header = headerData;
+
+        QMutexLocker archiveMutexLocker(&d->archiveMutex);
+        d->archiveFilePath = zipFileName;
+        d->pendingEntries = pendingEntries;
+        d->lazyArchive.swap(qzip);
+        d->updateArchiveFile();
+
+        if (format)
+            *format = ZipFormat;
+
+        return !d->header.isEmpty();
+    }
+
+    if (doUnzip(QFileInfo(fileName), *d->folder, &d->entryStates)) {
         QString headerPath;
 
         const QString normalPath = d->folder->filePath(DocumentFileSystemData::normalHeaderFile);
@@ -257,23 +508,120 @@ bool DocumentFileSystem::load(const QString &fileName, Format *format)
 
         if (format)
             *format = ZipFormat;
+
+        QMutexLocker archiveMutexLocker(&d->archiveMutex);
+        d->archiveFilePath = zipFileName;
     }
 
     return !d->header.isEmpty();
 }
 
-void doZipRecursively(const QDir &dir, const QDir &rootDir, QuaZip &qzip)
+struct DocumentFileSystemZipContext
+{
+    // Archive produced by the previous load/save, from which unchanged entries
+    // can be copied without decompressing and compressing them again.
+    QuaZip *previousZip = nullptr;
+    QSet<QString> dirtyPaths;
+    DocumentFileSystemEntryStates previousStates;
+
+    // Entries of the previous archive that were never extracted (lazy load), and
+    // must be carried over into the new archive as-is.
+    QSet<QString> pendingEntries;
+
+    // States of files as they were written into the new archive, and pending
+    // entries that were successfully carried over.
+    DocumentFileSystemEntryStates newStates;
+    QSet<QString> carriedOverEntries;
+
+    // Set when an entry could not be written into the new archive completely. Such an
+    // archive is not fit to replace the target.
+    bool failed = false;
+};
+
+enum RawZipEntryCopyResult { RawZipEntryCopied, RawZipEntryUnavailable, RawZipEntryCopyFailed };
+
+// Entries that cannot be found or opened in srcZip are reported as unavailable, and nothing
+// is written into dstZip for them. Once the entry is opened in dstZip, any failure leaves
+// a truncated entry behind, which is reported as a failed copy.
+RawZipEntryCopyResult copyRawZipEntry(const QString &name, QuaZip &srcZip, QuaZip &dstZip)
+{
+    if (!srcZip.setCurrentFile(name, QuaZip::csSensitive))
+        return RawZipEntryUnavailable;
+
+    QuaZipFileInfo64 srcFileInfo;
+    if (!srcZip.getCurrentFileInfo(&srcFileInfo))
+        return RawZipEntryUnavailable;
+
+    int method = 0, level = 0;
+    QuaZipFile srcFile(&srcZip);
+    if (!srcFile.open(QFile::ReadOnly, &method, &level, true))
+        return RawZipEntryUnavailable;
+
+    QuaZipFile dstFile(&dstZip);
+    if (!dstFile.open(QFile::WriteOnly, QuaZipNewInfo(srcFileInfo), nullptr, srcFileInfo.crc,
+                      method, level, true))
+        return RawZipEntryCopyFailed;
+
+    const int bufferLength = 65535;
+    char buffer[bufferLength];
+    qint64 bytesCopied = 0;
+    while (bytesCopied < qint64(srcFileInfo.compressedSize)) {
+        const qint64 nrBytes = srcFile.read(buffer, bufferLength);
+        if (nrBytes <= 0)
+            break;
+        if (dstFile.write(buffer, nrBytes) != nrBytes)
+            break;
+        bytesCopied += nrBytes;
+    }
+
+    dstFile.close();
+    srcFile.close();
+
+    const bool success = bytesCopied == qint64(srcFileInfo.compressedSize)
+            && dstFile.getZipError() == ZIP_OK;
+    return success ? RawZipEntryCopied : RawZipEntryCopyFailed;
+}
+
+void doZipRecursively(const QDir &dir, const QDir &rootDir, QuaZip &qzip,
+                      DocumentFileSystemZipContext &context)
 {
     const QFileInfoList entries = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs,
                                                     QDir::Name | QDir::DirsLast);
     for (const QFileInfo &entry : entries) {
+        if (context.failed)
+            return;
+
         if (entry.isDir()) {
-            doZipRecursively(entry.absoluteFilePath(), rootDir, qzip);
+            doZipRecursively(entry.absoluteFilePath(), rootDir, qzip, context);
             continue;
         }
 
         const QString srcFilePath = entry.absoluteFilePath();
         const QString dstFilePath = rootDir.relativeFilePath(srcFilePath);
+        const DocumentFileSystemEntryState entryState(entry);
+
+        // If the file hasn't changed since it was last loaded from or saved into
+        // the previous archive, then we simply copy its compressed bytes over. Should the
+        // entry not be available there, we deflate the file instead. But we cannot do that
+        // once a copy has failed half-way, because that would leave two entries by the
+        // same name in the archive.
+        if (context.previousZip != nullptr && !context.dirtyPaths.contains(dstFilePath)) {
+            const auto it = context.previousStates.constFind(dstFilePath);
+            if (it != context.previousStates.constEnd() && it.value() == entryState) {
+                const RawZipEntryCopyResult result =
+                        copyRawZipEntry(dstFilePath, *context.previousZip, qzip);
+                if (result == RawZipEntryCopied) {
+                    context.newStates.insert(dstFilePath, entryState);
+                    continue;
+                }
+
+                if (result == RawZipEntryCopyFailed) {
+                    qInfo("Could not copy '%s' from previous archive.", qPrintable(dstFilePath));
+                    context.failed = true;
+                    return;
+                }
+            }
+        }
 
         QFile srcFile(srcFilePath);
         if (!srcFile.open(QFile::ReadOnly)) {
@@ -298,33 +646,83 @@ void doZipRecursively(const QDir &dir, const QDir &rootDir, QuaZip &qzip)
 
         dstFile.close();
         srcFile.close();
+
+        context.newStates.insert(dstFilePath, entryState);
+    }
+}
+
+bool doZip(QuaZip &qzip, const QDir &rootDir, DocumentFileSystemZipContext &context)
+{
+    qzip.setUtf8Enabled(true);
+    if (!qzip.open(QuaZip::mdCreate))
+        return false;
+
+    context.newStates.clear();
+    context.carriedOverEntries.clear();
+    context.failed = false;
+    doZipRecursively(rootDir, rootDir, qzip, context);
+
+    // Entries which got extracted while we were walking the folder would have
+    // already been zipped, so they must not be carried over again.
+    QStringList pendingEntries = context.pendingEntries.values();
+    std::sort(pendingEntries.begin(), pendingEntries.end());
+    for (const QString &pendingEntry : qAsConst(pendingEntries)) {
+        if (context.newStates.contains(pendingEntry))
+            continue;
+
+        if (context.failed)
+            break;
+
+        // Pending entries exist nowhere else, an archive without any of them is not
+        // a complete document.
+        if (context.previousZip != nullptr
+            && copyRawZipEntry(pendingEntry, *context.previousZip, qzip) == RawZipEntryCopied)
+            context.carriedOverEntries += pendingEntry;
+        else {
+            qInfo("Could not carry over '%s' from previous archive.", qPrintable(pendingEntry));
+            context.failed = true;
+        }
     }
+
+    qzip.close();
+
+    return !context.failed && qzip.getZipError() == ZIP_OK;
 }
 
-bool doZip(const QFileInfo &fileInfo, const QDir &rootDir)
+bool doZip(const QFileInfo &fileInfo, const QDir &rootDir, DocumentFileSystemZipContext &context)
 {
     const QString zipFileName = fileInfo.absoluteFilePath();
 
     QuaZip qzip(zipFileName);
-    qzip.setUtf8Enabled(true);
-    if (!qzip.open(QuaZip::mdCreate)) {
+    if (!doZip(qzip, rootDir, context)) {
         qInfo("Could not create %s", qPrintable(zipFileName));
         return false;
     }
 
-    doZipRecursively(rootDir, rootDir, qzip);
+    return true;
+}
 
-    qzip.close();
+bool doZip(QSaveFile &saveFile, const QDir &rootDir, DocumentFileSystemZipContext &context)
+{
+    // QuaZip must not close the save-file, because QSaveFile only writes to the
+    // target upon commit().
+    QuaZip qzip(&saveFile);
+    qzip.setAutoClose(false);
+    if (!doZip(qzip, rootDir, context)) {
+        qInfo("Could not create %s", qPrintable(saveFile.fileName()));
+        return false;
+    }
 
     return true;
 }
 
-bool saveTask(const QByteArray &header, bool encrypt, const QDir &folder,
-              const QString &targetFileName, QMutex *mutex)
+bool saveTask(const QByteArray &header, const DocumentFileSystem::HeaderFunction &headerFunction,
+              bool encrypt, const QDir &folder, const QString &targetFileName,
+              const QSet<QString> &dirtyPaths, DocumentFileSystemData *d)
 {
-    QMutexLocker mutexLocker(mutex);
+    QMutexLocker mutexLocker(&d->folderMutex);
 
-    QByteArray headerData = header;
+    QByteArray headerData = headerFunction ? headerFunction() : header;
     if (encrypt) {
         SimpleCrypt sc(REST_CRYPT_KEY);
         headerData = sc.encryptToByteArray(headerData);
@@ -341,21 +739,113 @@ bool saveTask(const QByteArray &header, bool encrypt, const QDir &folder,
     if (!headerFile.commit())
         return false;
 
-    const QString tmpFileName = QStandardPaths::writableLocation(QStandardPaths::TempLocation)
-            + QStringLiteral("/scrite_") + QString::number(QDateTime::currentMSecsSinceEpoch())
-            + QStringLiteral("_temp.scrite");
+    DocumentFileSystemZipContext context;
+
+    QString archiveFilePath;
+    {
+        QMutexLocker archiveMutexLocker(&d->archiveMutex);
+        archiveFilePath = d->archiveFilePath;
+        context.pendingEntries = d->pendingEntries;
+
+        for (auto it = d->extractedStates.constBegin(); it != d->extractedStates.constEnd(); ++it)
+            d->entryStates.insert(it.key(), it.value());
+        d->extractedStates.clear();
+    }
 
-    const QFileInfo fileInfo(tmpFileName);
-    bool success = doZip(fileInfo, folder);
+    QScopedPointer<QuaZip> previousZip;
+    const bool incremental = d->incrementalSave && !d->entryStates.isEmpty();
+    if ((incremental || !context.pendingEntries.isEmpty()) && !archiveFilePath.isEmpty()) {
+        if (!d->archiveFile.isNull()) {
+            previousZip.reset(new QuaZip(d->archiveFile.data()));
+            previousZip->setAutoClose(false);
+        } else if (QFile::exists(archiveFilePath))
+            previousZip.reset(new QuaZip(archiveFilePath));
+    }
 
-    if (success && QFile::exists(tmpFileName) && QFileInfo(tmpFileName).size() > 0) {
-        if (QFile::exists(targetFileName))
-            success &= QFile::remove(targetFileName);
+    if (!previousZip.isNull()) {
+        previousZip->setUtf8Enabled(true);
+        if (previousZip->open(QuaZip::mdUnzip)) {
+            context.previousZip = previousZip.data();
+            if (incremental) {
+                context.dirtyPaths = dirtyPaths;
+                context.previousStates = d->entryStates;
+            }
+        }
+    }
+
+    // Previous archive could be the target itself, it must be closed before the rename
+    // happens on commit(). Otherwise it is kept open, so that pending entries remain
+    // available should the save fail.
+    const bool previousIsTarget =
+            !archiveFilePath.isEmpty() && QFileInfo(archiveFilePath) == QFileInfo(targetFileName);
+    auto closePreviousZip = [&]() {
+        if (context.previousZip != nullptr)
+            context.previousZip->close();
+        context.previousZip = nullptr;
+        previousZip.reset();
+
+        if (previousIsTarget) {
+            // Lazy load may have the previous archive open as well.
+            QMutexLocker archiveMutexLocker(&d->archiveMutex);
+            d->closeLazyArchive();
+            d->archiveFile.reset();
+        }
+    };
+
+    // The archive is streamed straight into a QSaveFile, which writes into a temporary
+    // file next to the target and renames it over the target on commit(). This way the
+    // archive is written exactly once, and the target file is never missing; even if
+    // we crash half-way through.
+    bool success = false;
+    QSaveFile targetFile(targetFileName);
+    if (targetFile.open(QFile::WriteOnly)) {
+        success = doZip(targetFile, folder, context);
         if (success)
-            success &= QFile::copy(tmpFileName, targetFileName);
+            success = targetFile.size() > 0;
+
+        closePreviousZip();
+
+        if (success)
+            success = targetFile.commit();
+        else
+            targetFile.cancelWriting();
+    } else {
+        // We may not be able to create files in the target's folder, even if the
+        // target itself is writable. Fallback to zipping into a temporary file and
+        // copying it over the target in that case.
+        const QString tmpFileName = QStandardPaths::writableLocation(QStandardPaths::TempLocation)
+                + QStringLiteral("/scrite_") + QString::number(QDateTime::currentMSecsSinceEpoch())
+                + QStringLiteral("_temp.scrite");
+
+        const QFileInfo fileInfo(tmpFileName);
+        success = doZip(fileInfo, folder, context);
+
+        closePreviousZip();
+
+        if (success && QFile::exists(tmpFileName) && QFileInfo(tmpFileName).size() > 0) {
+            if (QFile::exists(targetFileName))
+                success &= QFile::remove(targetFileName);
+            if (success)
+                success &= QFile::copy(tmpFileName, targetFileName);
+        }
         QFile::remove(tmpFileName);
     }
 
+    // If anything went wrong, then the next save should compress everything afresh.
+    // Entries still pending continue to be available in the previous archive.
+    QMutexLocker archiveMutexLocker(&d->archiveMutex);
+    if (success) {
+        d->entryStates = context.newStates;
+
+        // Entries that are still pending are extracted from the new archive from here on.
+        d->closeLazyArchive();
+        d->archiveFilePath = QFileInfo(targetFileName).absoluteFilePath();
+        d->pendingEntries.intersect(context.carriedOverEntries);
+    } else
+        d->entryStates.clear();
+
+    d->updateArchiveFile();
+
     return success;
 }
 
@@ -367,6 +857,10 @@ bool DocumentFileSystem::save(const QString &fileName, bool encrypt, SaveMode mo
     // Ensure that unwanted files are no longer in the DFS folder
     this->cleanup();
 
+    // Paths modified from here on will be considered for the next save.
+    QSet<QString> dirtyPaths;
+    dirtyPaths.swap(d->dirtyPaths);
+
 #if 0
     QFile file(fileName);
     if( !file.open(QFile::WriteOnly) )
@@ -417,21 +911,59 @@ bool DocumentFileSystem::save(const QString &fileName, bool encrypt, SaveMode mo
         watcher->setObjectName(saveTaskWatcher);
         connect(watcher, &QFutureWatcher<bool>::finished, this,
                 &DocumentFileSystem::saveTaskFinished);
-        watcher->setFuture(QtConcurrent::run(saveTask, d->header, encrypt, QDir(d->folder->path()),
-                                             fileName, &d->folderMutex));
+        const QByteArray header = d->header;
+        const HeaderFunction headerFunction = d->headerFunction;
+        const QDir folder(d->folder->path());
+        DocumentFileSystemData *data = d;
+        watcher->setFuture(QtConcurrent::run([=]() {
+            return saveTask(header, headerFunction, encrypt, folder, fileName, dirtyPaths, data);
+        }));
 
         return true;
     }
 
-    const bool ret =
-            saveTask(d->header, encrypt, QDir(d->folder->path()), fileName, &d->folderMutex);
+    const bool ret = saveTask(d->header, d->headerFunction, encrypt, QDir(d->folder->path()),
+                              fileName, dirtyPaths, d);
     return ret;
 #endif
 }
 
+void DocumentFileSystem::setIncrementalSaveEnabled(bool val)
+{
+    QMutexLocker mutexLocker(&d->folderMutex);
+    d->incrementalSave = val;
+}
+
+bool DocumentFileSystem::isIncrementalSaveEnabled() const
+{
+    return d->incrementalSave;
+}
+
+void DocumentFileSystem::setLazyLoadEnabled(bool val)
+{
+    QMutexLocker mutexLocker(&d->folderMutex);
+    d->lazyLoad = val;
+}
+
+bool DocumentFileSystem::isLazyLoadEnabled() const
+{
+    return d->lazyLoad;
+}
+
 void DocumentFileSystem::setHeader(const QByteArray &header)
 {
     d->header = header;
+    d->headerFunction = nullptr;
+    d->dirtyPaths += DocumentFileSystemData::normalHeaderFile;
+    d->dirtyPaths += DocumentFileSystemData::encryptedHeaderFile;
+}
+
+void DocumentFileSystem::setHeaderFunction(const HeaderFunction &function)
+{
+    d->header.clear();
+    d->headerFunction = function;
+    d->dirtyPaths += DocumentFileSystemData::normalHeaderFile;
+    d->dirtyPaths += DocumentFileSystemData::encryptedHeaderFile;
 }
 
 QByteArray DocumentFileSystem::header() const
@@ -439,6 +971,26 @@ QByteArray DocumentFileSystem::header() const
     return d->header;
 }
 
+DocumentFileSystem::HeaderFormat DocumentFileSystem::headerFormat() const
+{
+    return headerFormatOf(d->header);
+}
+
+DocumentFileSystem::HeaderFormat DocumentFileSystem::headerFormatOf(const QByteArray &header)
+{
+    return HeaderFormat(DocumentHeaderCodec::formatOf(header));
+}
+
+QByteArray DocumentFileSystem::encodeHeader(const QJsonObject &header, HeaderFormat format)
+{
+    return DocumentHeaderCodec::encode(header, DocumentHeaderCodec::Format(format));
+}
+
+QJsonObject DocumentFileSystem::decodeHeader(const QByteArray &header)
+{
+    return DocumentHeaderCodec::decode(header);
+}
+
 QFile *DocumentFileSystem::open(const QString &path, QFile::OpenMode mode)
 {
     if (path.isEmpty())
@@ -514,6 +1066,7 @@ QString DocumentFileSystem::add(const QString &fileName, const QString &ns)
                                   | QFileDevice::ReadUser | QFileDevice::WriteUser
                                   | QFileDevice::ReadGroup | QFileDevice::WriteGroup
                                   | QFileDevice::ReadOther | QFileDevice::WriteOther);
+        this->markDirty(path);
         return path;
     }
 
@@ -542,6 +1095,7 @@ QString DocumentFileSystem::duplicate(const QString &fileName, const QString &ns
                                   | QFileDevice::ReadUser | QFileDevice::WriteUser
                                   | QFileDevice::ReadGroup | QFileDevice::WriteGroup
                                   | QFileDevice::ReadOther | QFileDevice::WriteOther);
+        this->markDirty(path);
         return path;
     }
 
@@ -554,6 +1108,14 @@ bool DocumentFileSystem::remove(const QString &path)
     if (path.isEmpty())
         return false;
 
+    this->markDirty(path);
+
+    // Entries that were never extracted from the archive need not be extracted
+    // just to be removed.
+    const QString relPath = QDir::isAbsolutePath(path) ? this->relativePath(path) : path;
+    if (d->discardPendingEntry(relPath))
+        return true;
+
     const QString completePath = this->absolutePath(path);
     return QFile::remove(completePath);
 }
@@ -564,12 +1126,16 @@ QString DocumentFileSystem::absolutePath(const QString &path, bool mkpath) const
         return QString();
 
     if (QDir::isAbsolutePath(path)) {
-        if (path.startsWith(d->folder->path()))
+        if (path.startsWith(d->folder->path())) {
+            d->extractPendingEntry(this->relativePath(path));
             return path;
+        }
 
         return QString();
     }
 
+    d->extractPendingEntry(path);
+
     const QString ret = d->folder->filePath(path);
     const QFileInfo fi(ret);
     if (!fi.exists() && mkpath) {
@@ -605,6 +1171,9 @@ bool DocumentFileSystem::exists(const QString &path) const
     if (path.isEmpty())
         return false;
 
+    if (!QDir::isAbsolutePath(path) && d->isPendingEntry(path))
+        return true;
+
     const QString completePath = this->absolutePath(path);
     return QFile::exists(completePath);
 }
@@ -651,6 +1220,8 @@ QString DocumentFileSystem::addFile(const QString &srcFile, const QString &dstPa
     if (!QFile::copy(srcFile, dstPath))
         return QString();
 
+    this->markDirty(absDstPath);
+
     // That's it
     return this->relativePath(absDstPath);
 }
@@ -679,6 +1250,8 @@ QString DocumentFileSystem::addImage(const QImage &srcImage, const QString &dstP
     if (QFileInfo(absDstPath).isDir())
         return QString();
 
+    this->markDirty(absDstPath);
+
     // If the image passed to this function is empty, we just have
     // to delete a previously existing file.
     if (srcImage.isNull()) {
@@ -773,6 +1346,14 @@ bool DocumentFileSystem::unpack(QDataStream &ds)
     return true;
 }
 
+void DocumentFileSystem::markDirty(const QString &path)
+{
+    if (path.isEmpty())
+        return;
+
+    d->dirtyPaths += QDir::isAbsolutePath(path) ? this->relativePath(path) : QDir::cleanPath(path);
+}
+
 void DocumentFileSystem::saveTaskFinished()
 {
     if (this->sender() && this->sender()->objectName() == QStringLiteral("saveTaskWatcher")
@@ -799,6 +1380,8 @@ DocumentFile::DocumentFile(const QString &filePath, DocumentFileSystem *parent)
 DocumentFile::~DocumentFile()
 {
     if (m_fileSystem != nullptr) {
+        if (this->isOpen() && this->isWritable())
+            m_fileSystem->markDirty(this->fileName());
         m_fileSystem->d->files.removeOne(this);
         m_fileSystem = nullptr;
     }
@@ -807,6 +1390,8 @@ DocumentFile::~DocumentFile()
 void DocumentFile::onAboutToClose()
 {
     if (m_fileSystem != nullptr) {
+        if (this->isWritable())
+            m_fileSystem->markDirty(this->fileName());
         m_fileSystem->d->files.removeOne(this);
         m_fileSystem = nullptr;
     }
@@ -20,6 +20,9 @@
 #include <QSize>
 #include <QImage>
 #include <QFileInfo>
+#include <QJsonObject>
+
+#include <functional>
 
 class DocumentFile;
 
@@ -39,12 +42,42 @@ public:
     enum Format { UnknownFormat, ScriteFormat, ZipFormat };
     bool load(const QString &fileName, Format *format = nullptr);
 
+    // When enabled (default), load() only reads the central directory and header of
+    // ZIP documents. Other entries are extracted when they are first accessed.
+    void setLazyLoadEnabled(bool val);
+    bool isLazyLoadEnabled() const;
+
     enum SaveMode { BlockingSaveMode, NonBlockingSaveMode };
     bool save(const QString &fileName, bool encrypt = false, SaveMode mode = BlockingSaveMode);
 
+    // When enabled (default), save() copies compressed entries of files that haven't
+    // changed since the last load/save raw from the previous archive, and only deflates
+    // files that were modified, added or replaced in the mean time.
+    void setIncrementalSaveEnabled(bool val);
+    bool isIncrementalSaveEnabled() const;
+
     void setHeader(const QByteArray &header);
     QByteArray header() const;
 
+    // Header can also be supplied as a function, which is called on the thread that
+    // does the actual saving. This lets callers hand over a snapshot of the document
+    // and have it encoded off the main thread during NonBlockingSaveMode. header()
+    // returns an empty byte-array while a header function is set.
+    typedef std::function<QByteArray()> HeaderFunction;
+    void setHeaderFunction(const HeaderFunction &function);
+
+    // Header can either be indented JSON text or a versioned CBOR encoding of the
+    // same JSON object, which is faster to build and parse, and is more compact.
+    // Format of the header is detected from its contents upon load(). Encoding and decoding
+    // is done by DocumentHeaderCodec.
+    enum HeaderFormat { JsonHeaderFormat, BinaryHeaderFormat };
+    HeaderFormat headerFormat() const;
+
+    static HeaderFormat headerFormatOf(const QByteArray &header);
+    static QByteArray encodeHeader(const QJsonObject &header,
+                                   HeaderFormat format = JsonHeaderFormat);
+    static QJsonObject decodeHeader(const QByteArray &header);
+
     QFile *open(const QString &path, QFile::OpenMode mode = QFile::ReadOnly);
 
     QByteArray read(const QString &path);
@@ -81,6 +114,7 @@ private:
     bool pack(QDataStream &ds);
     bool unpack(QDataStream &ds);
     void saveTaskFinished();
+    void markDirty(const QString &path);
 
 private:
     friend class DocumentFile;
@@ -0,0 +1,67 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "documentheadercodec.h"
+
+#include <QtDebug>
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonDocument>
+
+// Binary headers are CBOR maps tagged with the self-describe signature, carrying
+// the header-format version and the document.
+static const int BinaryHeaderVersion = 1;
+static const char BinaryHeaderSignature[] = "\xd9\xd9\xf7";
+
+DocumentHeaderCodec::Format DocumentHeaderCodec::formatOf(const QByteArray &header)
+{
+    return header.startsWith(QByteArray::fromRawData(BinaryHeaderSignature, 3)) ? BinaryFormat
+                                                                                 : JsonFormat;
+}
+
+QByteArray DocumentHeaderCodec::encode(const QJsonObject &header, Format format)
+{
+    if (format == BinaryFormat) {
+        QCborMap map;
+        map.insert(QStringLiteral("version"), BinaryHeaderVersion);
+        map.insert(QStringLiteral("document"), QCborMap::fromJsonObject(header));
+        return QCborValue(QCborKnownTags::Signature, map).toCbor();
+    }
+
+    return QJsonDocument(header).toJson();
+}
+
+QJsonObject DocumentHeaderCodec::decode(const QByteArray &header)
+{
+    if (formatOf(header) == JsonFormat)
+        return QJsonDocument::fromJson(header).object();
+
+    QCborParserError error;
+    QCborValue value = QCborValue::fromCbor(header, &error);
+    if (error.error != QCborError::NoError) {
+        qInfo("Could not parse document header: %s", qPrintable(error.errorString()));
+        return QJsonObject();
+    }
+
+    if (value.isTag())
+        value = value.taggedValue();
+
+    const QCborMap map = value.toMap();
+    const int version = int(map.value(QStringLiteral("version")).toInteger());
+    if (version <= 0 || version > BinaryHeaderVersion) {
+        qInfo("Unsupported document header version: %d", version);
+        return QJsonObject();
+    }
+
+    return map.value(QStringLiteral("document")).toMap().toJsonObject();
+}
@@ -0,0 +1,35 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef DOCUMENTHEADERCODEC_H
+#define DOCUMENTHEADERCODEC_H
+
+#include <QByteArray>
+#include <QJsonObject>
+
+/**
+ * Encodes and decodes headers of Scrite documents. Depends on nothing but QtCore, so that
+ * tools can measure exactly what DocumentFileSystem reads and writes.
+ */
+class DocumentHeaderCodec
+{
+public:
+    // Must match DocumentFileSystem::HeaderFormat
+    enum Format { JsonFormat, BinaryFormat };
+
+    static Format formatOf(const QByteArray &header);
+    static QByteArray encode(const QJsonObject &header, Format format = JsonFormat);
+    static QJsonObject decode(const QByteArray &header);
+};
+
+#endif // DOCUMENTHEADERCODEC_H
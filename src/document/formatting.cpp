@@ -25,6 +25,8 @@
 #include <QMimeData>
 #include <QClipboard>
 #include <QPdfWriter>
+#include <QQuickItem>
+#include <QQuickWindow>
 #include <QScopeGuard>
 #include <QTextCursor>
 #include <QPageLayout>
@@ -1288,7 +1290,7 @@ SceneDocumentBlockUserData::SceneDocumentBlockUserData(const QTextBlock &textBlo
         m_spellCheckConnection =
                 QObject::connect(m_spellCheck, SIGNAL(misspelledFragmentsChanged()), m_binder,
                                  SLOT(onSpellCheckUpdated()), Qt::UniqueConnection);
-        m_spellCheck->scheduleUpdate();
+        this->scheduleSpellCheckUpdate();
     }
 
     if (m_textBlock.isValid())
@@ -1321,7 +1323,7 @@ void SceneDocumentBlockUserData::initializeSpellCheck(SceneDocumentBinder *binde
             m_spellCheckConnection =
                     QObject::connect(m_spellCheck, SIGNAL(misspelledFragmentsChanged()), binder,
                                      SLOT(onSpellCheckUpdated()), Qt::UniqueConnection);
-        m_spellCheck->scheduleUpdate();
+        this->scheduleSpellCheckUpdate();
     } else {
         if (m_spellCheckConnection)
             QObject::disconnect(m_spellCheckConnection);
@@ -1337,8 +1339,10 @@ bool SceneDocumentBlockUserData::shouldUpdateFromSpellCheck()
 
 void SceneDocumentBlockUserData::scheduleSpellCheckUpdate()
 {
-    if (!m_spellCheck.isNull())
+    if (!m_spellCheck.isNull()) {
+        m_spellCheck->setPriority(m_binder->spellCheckPriority());
         m_spellCheck->scheduleUpdate();
+    }
 }
 
 QList<TextFragment> SceneDocumentBlockUserData::misspelledFragments() const
@@ -1590,7 +1594,6 @@ public:
 
     QString word() const { return this->selectedText(); }
     bool isMisspelled() const { return m_misspelledFragment.isValid(); }
-    QStringList suggestions() const { return m_misspelledFragment.suggestions(); }
 
     void replace(const QString &word)
     {
@@ -1886,8 +1889,22 @@ void SceneDocumentBinder::setCursorPosition(int val)
                  __LINE__, val);
     } else {
         this->setCurrentElement(userData->sceneElement());
-        this->setWordUnderCursorIsMisspelled(cursor.isMisspelled());
-        this->setSpellingSuggestions(cursor.suggestions());
+        if (cursor.isMisspelled()) {
+            this->setWordUnderCursorIsMisspelled(true);
+            this->setSpellingSuggestions(QStringList());
+
+            const int position = m_cursorPosition;
+            SpellCheckService::requestSuggestions(
+                    cursor.word(), this, [=](const QStringList &suggestions) {
+                        // Cursor may have moved on, or the word may have been corrected,
+                        // while suggestions were looked up.
+                        if (m_cursorPosition == position && m_wordUnderCursorIsMisspelled)
+                            this->setSpellingSuggestions(suggestions);
+                    });
+        } else {
+            this->setWordUnderCursorIsMisspelled(false);
+            this->setSpellingSuggestions(QStringList());
+        }
 
         if (m_selectionStartPosition >= 0 && m_selectionEndPosition > 0
             && m_selectionStartPosition != m_selectionEndPosition) {
@@ -2186,7 +2203,7 @@ QStringList SceneDocumentBinder::spellingSuggestionsForWordAt(int position) cons
 
     SpellCheckCursor cursor(this->document(), position);
     if (cursor.isMisspelled())
-        return cursor.suggestions();
+        return SpellCheckService::suggestions(cursor.word());
 
     return QStringList();
 }
@@ -3000,6 +3017,24 @@ void SceneDocumentBinder::onSpellCheckUpdated()
         this->rehighlightBlockLater(block);
 }
 
+SpellCheckService::Priority SceneDocumentBinder::spellCheckPriority() const
+{
+    // When all delegates of the screenplay editor are loaded, paragraphs scrolled out of
+    // view should not hold up spell-check of those on screen.
+    QQuickItem *textEdit =
+            m_textDocument == nullptr ? nullptr : qobject_cast<QQuickItem *>(m_textDocument->parent());
+    if (textEdit == nullptr || textEdit->window() == nullptr)
+        return SpellCheckService::NormalPriority;
+
+    if (!textEdit->isVisible())
+        return SpellCheckService::LowPriority;
+
+    const QRectF windowRect(QPointF(0, 0), textEdit->window()->size());
+    const QRectF textEditRect = textEdit->mapRectToScene(textEdit->boundingRect());
+    return windowRect.intersects(textEditRect) ? SpellCheckService::HighPriority
+                                               : SpellCheckService::LowPriority;
+}
+
 void SceneDocumentBinder::onContentsChange(int from, int charsRemoved, int charsAdded)
 {
     if (m_initializingDocument || m_sceneIsBeingReset || m_sceneElementTaskIsRunning
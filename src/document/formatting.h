@@ -772,6 +772,7 @@ private:
     void resetCurrentElement();
     void onSceneElementChanged(SceneElement *element, Scene::SceneElementChangeType type);
     Q_SLOT void onSpellCheckUpdated();
+    SpellCheckService::Priority spellCheckPriority() const;
     void onContentsChange(int from, int charsRemoved, int charsAdded);
     void syncSceneFromDocument(int nrBlocks = -1);
 
@@ -29,11 +29,13 @@
 #include <QDateTime>
 #include <QByteArray>
 #include <QJsonArray>
+#include <QMetaEnum>
 #include <QJsonObject>
 #include <QUndoCommand>
 #include <QTextDocument>
 #include <QJsonDocument>
 #include <QFutureWatcher>
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <QTextBoundaryFinder>
 #include <QScopedValueRollback>
@@ -54,8 +56,31 @@ static QDataStream &operator>>(QDataStream &ds, QTextLayout::FormatRange &format
     return ds;
 }
 
+static QDataStream &operator<<(QDataStream &ds, const SceneElementSnapshot &snapshot)
+{
+    ds << snapshot.id << int(snapshot.type) << snapshot.text << int(snapshot.alignment)
+       << snapshot.textFormats;
+    return ds;
+}
+
+static QDataStream &operator>>(QDataStream &ds, SceneElementSnapshot &snapshot)
+{
+    int type = 0, alignment = 0;
+    ds >> snapshot.id >> type >> snapshot.text >> alignment >> snapshot.textFormats;
+    snapshot.type = SceneElement::Type(type);
+    snapshot.alignment = Qt::Alignment(alignment);
+    return ds;
+}
+
 class PushSceneUndoCommand;
-class SceneUndoCommand : public QUndoCommand
+
+/**
+ * Undo command for an edit of a scene, kept as the difference between the scene before and
+ * after the edit. Paragraph snapshots share data with paragraphs, so the snapshot taken
+ * before an edit costs a pointer copy per paragraph. Once the edit is done, only paragraphs
+ * inserted, removed or modified by it are kept, and undo & redo touch only those.
+ */
+class SceneUndoCommand : public CompactUndoCommand
 {
 public:
     static SceneUndoCommand *current;
@@ -70,16 +95,55 @@ public:
     int id() const { return ID; }
     bool mergeWith(const QUndoCommand *other);
 
+protected:
+    // CompactUndoCommand interface
+    qint64 stateSize() const;
+    QByteArray saveState() const;
+    bool loadState(const QByteArray &bytes);
+    void releaseState() { m_edits.clear(); }
+
 private:
-    QByteArray toByteArray(Scene *scene) const;
-    Scene *fromByteArray(const QByteArray &bytes) const;
+    struct SceneFields
+    {
+        QString title;
+        QColor color;
+        int cursorPosition = -1;
+        QString locationType;
+        QString location;
+        QString moment;
+    };
+
+    // Edits are applied in order on redo, and inverted in reverse order on undo. Index of
+    // an edit is that of the paragraph at the time the edit is applied.
+    struct ParagraphEdit
+    {
+        enum Kind { Insert, Remove, Modify };
+        Kind kind = Modify;
+        int index = -1;
+        SceneElementSnapshot before; // of Remove and Modify edits
+        SceneElementSnapshot after; // of Insert and Modify edits
+    };
+
+    static SceneFields captureFields(const Scene *scene);
+    static QVector<ParagraphEdit> diff(const QVector<SceneElementSnapshot> &before,
+                                       const QVector<SceneElementSnapshot> &after);
+    static bool isSameParagraph(const SceneElementSnapshot &a, const SceneElementSnapshot &b);
+
+    static bool insertParagraph(Scene *scene, int index, const SceneElementSnapshot &para);
+    static bool removeParagraph(Scene *scene, int index, const SceneElementSnapshot &para);
+    static bool modifyParagraph(Scene *scene, int index, const SceneElementSnapshot &para);
+
+    bool canApply(const Scene *scene, bool forward) const;
+    bool apply(bool forward);
 
 private:
     friend class PushSceneUndoCommand;
     Scene *m_scene = nullptr;
     QString m_sceneId;
-    QByteArray m_after;
-    QByteArray m_before;
+    SceneFields m_after;
+    SceneFields m_before;
+    QVector<SceneElementSnapshot> m_paragraphsBefore; // until the edit is done
+    QVector<ParagraphEdit> m_edits;
     bool m_allowMerging = true;
     char m_padding[7];
     QDateTime m_timestamp;
@@ -92,34 +156,43 @@ SceneUndoCommand::SceneUndoCommand(Scene *scene, bool allowMerging)
 {
     m_padding[0] = 0; // just to get rid of the unused private variable warning.
     m_sceneId = m_scene->id();
-    m_before = this->toByteArray(scene);
+    m_before = SceneUndoCommand::captureFields(scene);
+    m_paragraphsBefore = scene->elementSnapshots();
 }
 
 SceneUndoCommand::~SceneUndoCommand() { }
 
 void SceneUndoCommand::undo()
 {
+    if (!this->restoreState())
+        return;
+
     SceneUndoCommand::current = this;
-    Scene *scene = this->fromByteArray(m_before);
+    const bool success = this->apply(false);
     SceneUndoCommand::current = nullptr;
 
-    if (scene == nullptr)
+    if (!success)
         this->setObsolete(true);
 }
 
 void SceneUndoCommand::redo()
 {
     if (m_scene != nullptr) {
-        m_after = this->toByteArray(m_scene);
+        m_after = SceneUndoCommand::captureFields(m_scene);
+        m_edits = SceneUndoCommand::diff(m_paragraphsBefore, m_scene->elementSnapshots());
+        m_paragraphsBefore.clear();
         m_scene = nullptr;
         return;
     }
 
+    if (!this->restoreState())
+        return;
+
     SceneUndoCommand::current = this;
-    Scene *scene = this->fromByteArray(m_after);
+    const bool success = this->apply(true);
     SceneUndoCommand::current = nullptr;
 
-    if (scene == nullptr)
+    if (!success)
         this->setObsolete(true);
 }
 
@@ -133,9 +206,25 @@ bool SceneUndoCommand::mergeWith(const QUndoCommand *other)
         if (cmd->m_sceneId != m_sceneId)
             return false;
 
+        if (!this->restoreState())
+            return false;
+
         const qint64 timegap = qAbs(m_timestamp.msecsTo(cmd->m_timestamp));
         static qint64 minTimegap = 1000;
         if (timegap < minTimegap) {
+            for (const ParagraphEdit &edit : cmd->m_edits) {
+                // Keystrokes in a paragraph fold into one edit of that paragraph.
+                if (edit.kind == ParagraphEdit::Modify && !m_edits.isEmpty()) {
+                    ParagraphEdit &lastEdit = m_edits.last();
+                    if (lastEdit.kind != ParagraphEdit::Remove && lastEdit.index == edit.index) {
+                        lastEdit.after = edit.after;
+                        continue;
+                    }
+                }
+
+                m_edits.append(edit);
+            }
+
             m_after = cmd->m_after;
             m_timestamp = cmd->m_timestamp;
             return true;
@@ -145,14 +234,253 @@ bool SceneUndoCommand::mergeWith(const QUndoCommand *other)
     return false;
 }
 
-QByteArray SceneUndoCommand::toByteArray(Scene *scene) const
+qint64 SceneUndoCommand::stateSize() const
+{
+    // Text and formats of paragraphs in edits are what add up, the rest is noise.
+    auto snapshotSize = [](const SceneElementSnapshot &snapshot) {
+        return qint64(sizeof(SceneElementSnapshot))
+                + (snapshot.id.size() + snapshot.text.size()) * qint64(sizeof(QChar))
+                + snapshot.textFormats.size() * qint64(sizeof(QTextLayout::FormatRange) + 64);
+    };
+
+    qint64 ret = 0;
+    for (const ParagraphEdit &edit : m_edits)
+        ret += sizeof(ParagraphEdit) + snapshotSize(edit.before) + snapshotSize(edit.after);
+
+    return ret;
+}
+
+QByteArray SceneUndoCommand::saveState() const
+{
+    QByteArray ret;
+    QDataStream ds(&ret, QIODevice::WriteOnly);
+    ds << m_edits.size();
+    for (const ParagraphEdit &edit : m_edits)
+        ds << int(edit.kind) << edit.index << edit.before << edit.after;
+    return ret;
+}
+
+bool SceneUndoCommand::loadState(const QByteArray &bytes)
+{
+    QDataStream ds(bytes);
+
+    int nrEdits = 0;
+    ds >> nrEdits;
+
+    QVector<ParagraphEdit> edits(qMax(nrEdits, 0));
+    for (ParagraphEdit &edit : edits) {
+        int kind = 0;
+        ds >> kind >> edit.index >> edit.before >> edit.after;
+        edit.kind = ParagraphEdit::Kind(kind);
+    }
+
+    if (ds.status() != QDataStream::Ok)
+        return false;
+
+    m_edits = edits;
+    return true;
+}
+
+SceneUndoCommand::SceneFields SceneUndoCommand::captureFields(const Scene *scene)
+{
+    SceneFields ret;
+    ret.title = scene->title();
+    ret.color = scene->color();
+    ret.cursorPosition = scene->cursorPosition();
+    ret.locationType = scene->heading()->locationType();
+    ret.location = scene->heading()->location();
+    ret.moment = scene->heading()->moment();
+    return ret;
+}
+
+QVector<SceneUndoCommand::ParagraphEdit>
+SceneUndoCommand::diff(const QVector<SceneElementSnapshot> &before,
+                       const QVector<SceneElementSnapshot> &after)
+{
+    QVector<ParagraphEdit> ret;
+
+    // Paragraphs are matched by id. Edits almost always insert, remove or change paragraphs
+    // in one place, so everything before and after that place is left as is.
+    const int nrBefore = before.size();
+    const int nrAfter = after.size();
+
+    int prefix = 0;
+    while (prefix < nrBefore && prefix < nrAfter && before.at(prefix).id == after.at(prefix).id)
+        ++prefix;
+
+    int suffix = 0;
+    while (suffix < nrBefore - prefix && suffix < nrAfter - prefix
+           && before.at(nrBefore - 1 - suffix).id == after.at(nrAfter - 1 - suffix).id)
+        ++suffix;
+
+    ParagraphEdit edit;
+
+    edit.kind = ParagraphEdit::Remove;
+    edit.after = SceneElementSnapshot();
+    for (int i = nrBefore - suffix - 1; i >= prefix; i--) {
+        edit.index = i;
+        edit.before = before.at(i);
+        ret.append(edit);
+    }
+
+    edit.kind = ParagraphEdit::Insert;
+    edit.before = SceneElementSnapshot();
+    for (int i = prefix; i < nrAfter - suffix; i++) {
+        edit.index = i;
+        edit.after = after.at(i);
+        ret.append(edit);
+    }
+
+    // Unchanged paragraphs share text and formats with their snapshots, comparing them
+    // costs a pointer compare.
+    edit.kind = ParagraphEdit::Modify;
+    auto addModifyEdit = [&](int beforeIndex, int afterIndex) {
+        if (SceneUndoCommand::isSameParagraph(before.at(beforeIndex), after.at(afterIndex)))
+            return;
+
+        edit.index = afterIndex;
+        edit.before = before.at(beforeIndex);
+        edit.after = after.at(afterIndex);
+        ret.append(edit);
+    };
+
+    for (int i = 0; i < prefix; i++)
+        addModifyEdit(i, i);
+
+    for (int i = suffix; i >= 1; i--)
+        addModifyEdit(nrBefore - i, nrAfter - i);
+
+    return ret;
+}
+
+bool SceneUndoCommand::isSameParagraph(const SceneElementSnapshot &a,
+                                       const SceneElementSnapshot &b)
 {
-    return scene->toByteArray();
+    return a.type == b.type && a.alignment == b.alignment && a.text == b.text
+            && a.textFormats == b.textFormats;
 }
 
-Scene *SceneUndoCommand::fromByteArray(const QByteArray &bytes) const
+bool SceneUndoCommand::insertParagraph(Scene *scene, int index, const SceneElementSnapshot &para)
 {
-    return Scene::fromByteArray(bytes);
+    if (index < 0 || index > scene->elementCount())
+        return false;
+
+    SceneElement *element = new SceneElement(scene);
+    element->setId(para.id);
+    element->setType(para.type);
+    element->setText(para.text);
+    element->setAlignment(para.alignment);
+    element->setTextFormats(para.textFormats);
+    scene->insertElementAt(element, index);
+    return true;
+}
+
+bool SceneUndoCommand::removeParagraph(Scene *scene, int index, const SceneElementSnapshot &para)
+{
+    SceneElement *element = scene->elementAt(index);
+    if (element == nullptr || element->id() != para.id)
+        return false;
+
+    scene->removeElement(element);
+    return true;
+}
+
+bool SceneUndoCommand::modifyParagraph(Scene *scene, int index, const SceneElementSnapshot &para)
+{
+    SceneElement *element = scene->elementAt(index);
+    if (element == nullptr || element->id() != para.id)
+        return false;
+
+    element->setType(para.type);
+    element->setText(para.text);
+    element->setAlignment(para.alignment);
+    element->setTextFormats(para.textFormats);
+    return true;
+}
+
+bool SceneUndoCommand::canApply(const Scene *scene, bool forward) const
+{
+    // Edits are checked against paragraph IDs as they would be after each edit, so that
+    // the scene is left untouched unless all of them can be applied.
+    QStringList ids;
+    ids.reserve(scene->elementCount());
+    for (int i = 0; i < scene->elementCount(); i++)
+        ids.append(scene->elementAt(i)->id());
+
+    for (int i = 0; i < m_edits.size(); i++) {
+        const ParagraphEdit &edit = forward ? m_edits.at(i) : m_edits.at(m_edits.size() - 1 - i);
+        const bool inserts = edit.kind == (forward ? ParagraphEdit::Insert : ParagraphEdit::Remove);
+        const bool removes = edit.kind == (forward ? ParagraphEdit::Remove : ParagraphEdit::Insert);
+        const SceneElementSnapshot &para = edit.kind == ParagraphEdit::Remove ? edit.before
+                : edit.kind == ParagraphEdit::Insert                          ? edit.after
+                : forward                                                     ? edit.after
+                                                                              : edit.before;
+
+        if (inserts) {
+            if (edit.index < 0 || edit.index > ids.size())
+                return false;
+            ids.insert(edit.index, para.id);
+            continue;
+        }
+
+        if (edit.index < 0 || edit.index >= ids.size() || ids.at(edit.index) != para.id)
+            return false;
+
+        if (removes)
+            ids.removeAt(edit.index);
+    }
+
+    return true;
+}
+
+bool SceneUndoCommand::apply(bool forward)
+{
+    const Structure *structure = ScriteDocument::instance()->structure();
+    const StructureElement *element = structure->findElementBySceneID(m_sceneId);
+    Scene *scene = element ? element->scene() : nullptr;
+    if (scene == nullptr || !this->canApply(scene, forward))
+        return false;
+
+    // Changes made while undoing or redoing must not push commands of their own.
+    QScopedValueRollback<bool> ure(scene->m_undoRedoEnabled, false);
+
+    const SceneFields &fields = forward ? m_after : m_before;
+
+    // Editors rebuild their text documents when a scene resets. Edits that don't touch
+    // paragraphs, like those of the scene heading, don't need that.
+    const bool resetScene = !m_edits.isEmpty();
+    if (resetScene)
+        emit scene->sceneAboutToReset();
+
+    scene->setTitle(fields.title);
+    scene->setColor(fields.color);
+    scene->setCursorPosition(fields.cursorPosition);
+    scene->heading()->setLocationType(fields.locationType);
+    scene->heading()->setLocation(fields.location);
+    scene->heading()->setMoment(fields.moment);
+
+    bool success = true;
+    for (int i = 0; i < m_edits.size() && success; i++) {
+        const ParagraphEdit &edit = forward ? m_edits.at(i) : m_edits.at(m_edits.size() - 1 - i);
+        switch (edit.kind) {
+        case ParagraphEdit::Insert:
+            success = forward ? insertParagraph(scene, edit.index, edit.after)
+                              : removeParagraph(scene, edit.index, edit.after);
+            break;
+        case ParagraphEdit::Remove:
+            success = forward ? removeParagraph(scene, edit.index, edit.before)
+                              : insertParagraph(scene, edit.index, edit.before);
+            break;
+        case ParagraphEdit::Modify:
+            success = modifyParagraph(scene, edit.index, forward ? edit.after : edit.before);
+            break;
+        }
+    }
+
+    if (resetScene)
+        emit scene->sceneReset(fields.cursorPosition);
+
+    return success;
 }
 
 class PushSceneUndoCommand
@@ -384,6 +712,8 @@ SceneElement::SceneElement(QObject *parent)
     connect(this, &SceneElement::typeChanged, this, &SceneElement::elementChanged);
     connect(this, &SceneElement::textChanged, this, &SceneElement::elementChanged);
     connect(this, &SceneElement::elementChanged, [=]() { this->markAsModified(); });
+    connect(this, &SceneElement::idChanged, [=]() { this->markAsModified(); });
+    connect(this, &SceneElement::alignmentChanged, [=]() { this->markAsModified(); });
 
     if (m_scene != nullptr)
         connect(this, &SceneElement::wordCountChanged, m_scene, &Scene::evaluateWordCountLater,
@@ -748,7 +1078,34 @@ void SceneElement::serializeToJson(QJsonObject &json) const
         json.insert(QLatin1String("#textFormats"), jtextFormats);
 }
 
+SceneElementSnapshot SceneElement::snapshot() const
+{
+    SceneElementSnapshot ret;
+    ret.id = this->id();
+    ret.type = m_type;
+    ret.text = m_text;
+    ret.alignment = m_alignment;
+    ret.textFormats = m_textFormats;
+    return ret;
+}
+
+void SceneElement::restoreSnapshot(const SceneElementSnapshot &snapshot)
+{
+    // Same sequence of property writes as QObjectSerializer::fromJson()
+    this->setId(snapshot.id);
+    this->setType(snapshot.type);
+    this->setText(snapshot.text);
+    this->setAlignment(snapshot.alignment);
+    this->finishDeserialization(snapshot.textFormats);
+}
+
 void SceneElement::deserializeFromJson(const QJsonObject &json)
+{
+    const QJsonArray jtextFormats = json.value(QLatin1String("#textFormats")).toArray();
+    this->finishDeserialization(textFormatsFromJson(jtextFormats));
+}
+
+void SceneElement::finishDeserialization(const QVector<QTextLayout::FormatRange> &textFormats)
 {
     if (m_type == SceneElement::Character) {
         const int bo = m_text.indexOf(QStringLiteral("("));
@@ -760,8 +1117,7 @@ void SceneElement::deserializeFromJson(const QJsonObject &json)
         }
     }
 
-    const QJsonArray jtextFormats = json.value(QLatin1String("#textFormats")).toArray();
-    this->setTextFormats(textFormatsFromJson(jtextFormats));
+    this->setTextFormats(textFormats);
 
     this->evaluateWordCountLater();
 }
@@ -972,6 +1328,135 @@ void SceneElement::evaluateWordCountLater()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+QJsonObject SceneElementSnapshot::toJson() const
+{
+    // Meta-object data is static, so it is safe to look it up from any thread.
+    static const QMetaObject *mo = &SceneElement::staticMetaObject;
+    static const QMetaEnum typeEnum = mo->property(mo->indexOfProperty("type")).enumerator();
+    static const QMetaEnum alignmentEnum =
+            mo->property(mo->indexOfProperty("alignment")).enumerator();
+
+    // QObjectSerializer::toJson() writes enums and flags using QMetaEnum::valueToKey(),
+    // since QMetaProperty reports flags as enum types too. We do the same here.
+    QJsonObject ret;
+    ret.insert(QStringLiteral("id"), id);
+    ret.insert(QStringLiteral("type"), QString::fromLatin1(typeEnum.valueToKey(type)));
+    ret.insert(QStringLiteral("text"), text);
+    ret.insert(QStringLiteral("alignment"),
+               QString::fromLatin1(alignmentEnum.valueToKey(int(alignment))));
+
+    const QJsonArray jtextFormats = SceneElement::textFormatsToJson(textFormats);
+    if (!jtextFormats.isEmpty())
+        ret.insert(QLatin1String("#textFormats"), jtextFormats);
+
+    return ret;
+}
+
+SceneElementSnapshot SceneElementSnapshot::fromJson(const QJsonObject &json)
+{
+    static const QMetaObject *mo = &SceneElement::staticMetaObject;
+    static const QMetaEnum typeEnum = mo->property(mo->indexOfProperty("type")).enumerator();
+    static const QMetaEnum alignmentEnum =
+            mo->property(mo->indexOfProperty("alignment")).enumerator();
+
+    SceneElementSnapshot ret;
+
+    auto it = json.constFind(QStringLiteral("id"));
+    if (it != json.constEnd())
+        ret.id = it.value().toString();
+
+    it = json.constFind(QStringLiteral("type"));
+    if (it != json.constEnd())
+        ret.type = SceneElement::Type(typeEnum.keyToValue(it.value().toString().toLatin1()));
+
+    it = json.constFind(QStringLiteral("text"));
+    if (it != json.constEnd())
+        ret.text = it.value().toString();
+
+    it = json.constFind(QStringLiteral("alignment"));
+    if (it != json.constEnd()) {
+        const QByteArray key = it.value().toString().toLatin1();
+        ret.alignment = Qt::Alignment(key.isEmpty() ? 0 : alignmentEnum.keysToValue(key));
+    }
+
+    const QJsonArray jtextFormats = json.value(QLatin1String("#textFormats")).toArray();
+    ret.textFormats = SceneElement::textFormatsFromJson(jtextFormats);
+
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static SceneElementsLoader *CurrentSceneElementsLoader = nullptr;
+
+static QVector<SceneElementSnapshot> SceneElementsLoader_Task(const QJsonArray &elements)
+{
+    QVector<SceneElementSnapshot> ret;
+    ret.reserve(elements.size());
+    for (const QJsonValue &element : elements)
+        ret.append(SceneElementSnapshot::fromJson(element.toObject()));
+    return ret;
+}
+
+SceneElementsLoader::SceneElementsLoader(const QJsonArray &structureElements)
+{
+    const QString sceneKey = QStringLiteral("scene");
+    const QString idKey = QStringLiteral("id");
+    const QString elementsKey = QStringLiteral("elements");
+
+    QVector<QJsonArray> scenes;
+    scenes.reserve(structureElements.size());
+    for (const QJsonValue &item : structureElements) {
+        const QJsonObject scene = item.toObject().value(sceneKey).toObject();
+        const QString sceneId = scene.value(idKey).toString();
+        if (sceneId.isEmpty() || m_sceneIndexes.contains(sceneId))
+            continue;
+
+        m_sceneIndexes.insert(sceneId, scenes.size());
+        scenes.append(scene.value(elementsKey).toArray());
+    }
+
+    m_future = QtConcurrent::mapped(scenes, SceneElementsLoader_Task);
+
+    m_previous = ::CurrentSceneElementsLoader;
+    ::CurrentSceneElementsLoader = this;
+}
+
+SceneElementsLoader::~SceneElementsLoader()
+{
+    ::CurrentSceneElementsLoader = m_previous;
+
+    // Scenes that were never picked up must not leave work running behind us.
+    m_future.cancel();
+    m_future.waitForFinished();
+}
+
+SceneElementsLoader *SceneElementsLoader::current()
+{
+    return ::CurrentSceneElementsLoader;
+}
+
+bool SceneElementsLoader::takeElements(const QString &sceneId,
+                                       QVector<SceneElementSnapshot> &elements)
+{
+    const auto it = m_sceneIndexes.find(sceneId);
+    if (it == m_sceneIndexes.end())
+        return false;
+
+    const int index = it.value();
+    m_sceneIndexes.erase(it);
+
+    // Blocks only if the thread pool hasn't gotten to this scene yet.
+    elements = m_future.resultAt(index);
+
+    if (m_sceneLoadedCallback)
+        m_sceneLoadedCallback();
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 DistinctElementValuesMap::DistinctElementValuesMap(SceneElement::Type type) : m_type(type) { }
 
 DistinctElementValuesMap::~DistinctElementValuesMap() { }
@@ -984,16 +1469,29 @@ bool DistinctElementValuesMap::include(SceneElement *element)
         return false;
 
     if (element->type() == m_type) {
-        const bool ret = this->remove(element);
-
         QString newName = element->formattedText();
         newName = newName.section('(', 0, 0).trimmed();
+
+        // Most edits of an element leave its value as it was.
+        const auto it = m_forwardMap.constFind(element);
+        if (it != m_forwardMap.constEnd() && it.value() == newName)
+            return false;
+
+        bool ret = this->remove(element);
         if (newName.isEmpty())
             return ret;
 
         m_forwardMap[element] = newName;
-        m_reverseMap[newName].append(element);
-        return true;
+
+        QList<SceneElement *> &list = m_reverseMap[newName];
+        if (list.isEmpty()) {
+            this->recordValueAdded(newName);
+            ret = true;
+        } else if (list.size() == 1 && this->isMuteValue(list))
+            ret = true;
+        list.append(element);
+
+        return ret;
     }
 
     if (m_forwardMap.contains(element))
@@ -1012,15 +1510,12 @@ bool DistinctElementValuesMap::remove(SceneElement *element)
         if (list.removeOne(element)) {
             if (list.isEmpty()) {
                 m_reverseMap.remove(oldName);
+                this->recordValueRemoved(oldName);
                 return true;
             }
 
-            if (list.size() == 1) {
-                const QVariant value =
-                        m_type == SceneElement::Character ? list.first()->property("#mute") : false;
-                if (value.isValid() && value.toBool())
-                    return true;
-            }
+            if (list.size() == 1 && this->isMuteValue(list))
+                return true;
         }
     }
 
@@ -1039,6 +1534,7 @@ bool DistinctElementValuesMap::remove(const QString &name)
     for (SceneElement *element : elements)
         m_forwardMap.take(element);
 
+    this->recordValueRemoved(name);
     return true;
 }
 
@@ -1069,6 +1565,51 @@ void DistinctElementValuesMap::include(const DistinctElementValuesMap &other)
         this->include(element);
 }
 
+void DistinctElementValuesMap::setTrackChanges(bool val)
+{
+    m_trackChanges = val;
+    m_addedValues.clear();
+    m_removedValues.clear();
+}
+
+bool DistinctElementValuesMap::takeChanges(QSet<QString> *addedValues,
+                                           QSet<QString> *removedValues)
+{
+    const bool ret = !m_addedValues.isEmpty() || !m_removedValues.isEmpty();
+
+    if (addedValues)
+        *addedValues = m_addedValues;
+    if (removedValues)
+        *removedValues = m_removedValues;
+
+    m_addedValues.clear();
+    m_removedValues.clear();
+
+    return ret;
+}
+
+bool DistinctElementValuesMap::isMuteValue(const QList<SceneElement *> &elements) const
+{
+    if (m_type != SceneElement::Character || elements.size() != 1)
+        return false;
+
+    const QVariant value = elements.first()->property("#mute");
+    return value.isValid() && value.toBool();
+}
+
+void DistinctElementValuesMap::recordValueAdded(const QString &value)
+{
+    // A value removed and added back since the last takeChanges() hasn't changed at all.
+    if (m_trackChanges && !m_removedValues.remove(value))
+        m_addedValues.insert(value);
+}
+
+void DistinctElementValuesMap::recordValueRemoved(const QString &value)
+{
+    if (m_trackChanges && !m_addedValues.remove(value))
+        m_removedValues.insert(value);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 Scene::Scene(QObject *parent) : QAbstractListModel(parent)
@@ -2148,6 +2689,38 @@ void Scene::setCharacterRelationshipGraph(const QJsonObject &val)
     emit characterRelationshipGraphChanged();
 }
 
+QVector<SceneElementSnapshot> Scene::elementSnapshots() const
+{
+    QVector<SceneElementSnapshot> ret;
+    ret.reserve(m_elements.size());
+    for (const SceneElement *element : m_elements)
+        ret.append(element->snapshot());
+    return ret;
+}
+
+static bool SceneElementsSerializedSeparately = false;
+
+void Scene::setElementsSerializedSeparately(bool val)
+{
+    ::SceneElementsSerializedSeparately = val;
+}
+
+bool Scene::isElementsSerializedSeparately()
+{
+    return ::SceneElementsSerializedSeparately;
+}
+
+bool Scene::canSerialize(const QMetaObject *mo, const QMetaProperty &prop) const
+{
+    const bool separately =
+            ::SceneElementsSerializedSeparately || SceneElementsLoader::current() != nullptr;
+    if (!separately || mo != &Scene::staticMetaObject)
+        return true;
+
+    static const int elementsPropIndex = Scene::staticMetaObject.indexOfProperty("elements");
+    return prop.propertyIndex() != elementsPropIndex;
+}
+
 void Scene::serializeToJson(QJsonObject &json) const
 {
     const QStringList names = m_characterElementMap.characterNames();
@@ -2191,6 +2764,32 @@ private:
 
 void Scene::deserializeFromJson(const QJsonObject &json)
 {
+    SceneElementsLoader *elementsLoader = SceneElementsLoader::current();
+    if (elementsLoader != nullptr && m_elements.isEmpty()) {
+        QList<SceneElement *> elements;
+
+        QVector<SceneElementSnapshot> snapshots;
+        if (elementsLoader->takeElements(json.value(QStringLiteral("id")).toString(), snapshots)) {
+            elements.reserve(snapshots.size());
+            for (const SceneElementSnapshot &snapshot : qAsConst(snapshots)) {
+                SceneElement *element = new SceneElement(this);
+                element->restoreSnapshot(snapshot);
+                elements.append(element);
+            }
+        } else {
+            // Scene wasn't known to the loader, so we load its elements right here.
+            const QJsonArray jelements = json.value(QStringLiteral("elements")).toArray();
+            elements.reserve(jelements.size());
+            for (const QJsonValue &jelement : jelements) {
+                SceneElement *element = new SceneElement(this);
+                QObjectSerializer::fromJson(jelement.toObject(), element);
+                elements.append(element);
+            }
+        }
+
+        this->setElements(elements);
+    }
+
     const QJsonArray invisibleCharacters =
             json.value(QStringLiteral("#invisibleCharacters")).toArray();
     if (!invisibleCharacters.isEmpty())
@@ -15,8 +15,10 @@
 #define SCENE_H
 
 #include <QMap>
+#include <QSet>
 #include <QList>
 #include <QColor>
+#include <QFuture>
 #include <QPointer>
 #include <QQmlEngine>
 #include <QJsonArray>
@@ -29,6 +31,8 @@
 #include <QQuickTextDocument>
 #include <QImage>
 
+#include <functional>
+
 #include "notes.h"
 #include "modifiable.h"
 #include "attachments.h"
@@ -45,6 +49,7 @@ class SceneElement;
 class StructureElement;
 class SceneDocumentBinder;
 class PushSceneUndoCommand;
+struct SceneElementSnapshot;
 
 class SceneHeading : public QObject, public Modifiable
 {
@@ -103,6 +108,7 @@ protected:
 private:
     friend class Scene;
     void renameCharacter(const QString &from, const QString &to);
+    void finishDeserialization(const QVector<QTextLayout::FormatRange> &textFormats);
 
     enum Mode { DisplayMode, EditMode };
     QString toString(Mode mode) const;
@@ -203,6 +209,7 @@ public:
 
     void serializeToJson(QJsonObject &) const;
     void deserializeFromJson(const QJsonObject &obj);
+    const Modifiable *serializationCacheKey() const { return this; }
 
     // For use with SceneDocumentBinder, ScreenplayTextDocument
     void setTextFormats(const QVector<QTextLayout::FormatRange> &formats);
@@ -211,6 +218,11 @@ public:
     static QJsonArray textFormatsToJson(const QVector<QTextLayout::FormatRange> &formats);
     static QVector<QTextLayout::FormatRange> textFormatsFromJson(const QJsonArray &array);
 
+    // For serializing and deserializing elements off the main thread.
+    // See SceneElementSnapshot.
+    SceneElementSnapshot snapshot() const;
+    void restoreSnapshot(const SceneElementSnapshot &snapshot);
+
 protected:
     bool event(QEvent *event);
     void timerEvent(QTimerEvent *event);
@@ -237,6 +249,59 @@ private:
     QMap<int, int> m_changeCounters;
 };
 
+/**
+ * Value snapshot of the serializable state of a SceneElement. All members are implicitly
+ * shared Qt types, so taking a snapshot costs next to nothing. Once taken, the snapshot can
+ * be converted to JSON on any thread.
+ */
+struct SceneElementSnapshot
+{
+    QString id;
+    SceneElement::Type type = SceneElement::Action;
+    QString text;
+    Qt::Alignment alignment;
+    QVector<QTextLayout::FormatRange> textFormats;
+
+    // Returns the same JSON that QObjectSerializer::toJson() returns for SceneElement.
+    QJsonObject toJson() const;
+
+    // Returns what QObjectSerializer::fromJson() would load into SceneElement.
+    static SceneElementSnapshot fromJson(const QJsonObject &json);
+};
+
+/**
+ * Loading a document constructs every scene and its elements on the main thread. To keep
+ * that short, SceneElementsLoader turns JSON of all scene elements in a document into
+ * SceneElementSnapshot values on a thread pool, as soon as it is created. While it exists,
+ * scenes deserialized on the main thread skip the "elements" array in their JSON, and
+ * instead wait for snapshots of their elements and construct elements from them.
+ */
+class SceneElementsLoader
+{
+public:
+    // Pass the "elements" array of structure JSON
+    explicit SceneElementsLoader(const QJsonArray &structureElements);
+    ~SceneElementsLoader();
+
+    static SceneElementsLoader *current();
+
+    int sceneCount() const { return m_sceneIndexes.size(); }
+
+    // Called on the main thread, each time a scene picks up its elements.
+    void setSceneLoadedCallback(const std::function<void()> &callback)
+    {
+        m_sceneLoadedCallback = callback;
+    }
+
+    bool takeElements(const QString &sceneId, QVector<SceneElementSnapshot> &elements);
+
+private:
+    QHash<QString, int> m_sceneIndexes;
+    QFuture<QVector<SceneElementSnapshot>> m_future;
+    std::function<void()> m_sceneLoadedCallback;
+    SceneElementsLoader *m_previous = nullptr;
+};
+
 class DistinctElementValuesMap
 {
 public:
@@ -257,10 +322,24 @@ public:
 
     void include(const DistinctElementValuesMap &other);
 
+    // When enabled, values added to and removed from distinctValues() are recorded, so that
+    // indexes built on top of this map can be updated incrementally. takeChanges() returns
+    // true if there were any changes since it was last called.
+    void setTrackChanges(bool val);
+    bool takeChanges(QSet<QString> *addedValues, QSet<QString> *removedValues);
+
+private:
+    bool isMuteValue(const QList<SceneElement *> &elements) const;
+    void recordValueAdded(const QString &value);
+    void recordValueRemoved(const QString &value);
+
 private:
     SceneElement::Type m_type = SceneElement::Character;
     QMap<SceneElement *, QString> m_forwardMap;
     QMap<QString, QList<SceneElement *>> m_reverseMap;
+    bool m_trackChanges = false;
+    QSet<QString> m_addedValues;
+    QSet<QString> m_removedValues;
 };
 
 class CharacterElementMap : public DistinctElementValuesMap
@@ -538,7 +617,15 @@ public:
     Q_PROPERTY(Attachments *attachments READ attachments CONSTANT)
     Attachments *attachments() const { return m_attachments; }
 
+    // For serializing elements off the main thread. While elements are serialized
+    // separately, QObjectSerializer::toJson() leaves them out of Scene's JSON. The
+    // same happens with QObjectSerializer::fromJson() while a SceneElementsLoader exists.
+    QVector<SceneElementSnapshot> elementSnapshots() const;
+    static void setElementsSerializedSeparately(bool val);
+    static bool isElementsSerializedSeparately();
+
     // QObjectSerializer::Interface interface
+    bool canSerialize(const QMetaObject *mo, const QMetaProperty &prop) const;
     void serializeToJson(QJsonObject &json) const;
     void deserializeFromJson(const QJsonObject &json);
     bool canSetPropertyFromObjectList(const QString &propName) const;
@@ -582,6 +669,7 @@ private:
     friend class SceneElement;
     friend class SceneHeading;
     friend class SceneDocumentBinder;
+    friend class SceneUndoCommand;
 
     QString m_act;
     Type m_type = Standard;
@@ -17,6 +17,7 @@
 #include "application.h"
 #include "textlimiter.h"
 #include "timeprofiler.h"
+#include "searchengine.h"
 #include "scritedocument.h"
 #include "garbagecollector.h"
 
@@ -223,6 +224,10 @@ void ScreenplayElement::setScene(Scene *val)
     connect(m_scene, &Scene::typeChanged, this, &ScreenplayElement::sceneTypeChanged);
     connect(m_scene, &Scene::groupsChanged, this, &ScreenplayElement::onSceneGroupsChanged);
     connect(m_scene, &Scene::wordCountChanged, this, &ScreenplayElement::wordCountChanged);
+    connect(m_scene, &Scene::sceneElementChanged, this, &ScreenplayElement::sceneElementChanged);
+    connect(m_scene, &Scene::aboutToRemoveSceneElement, this,
+            &ScreenplayElement::aboutToRemoveSceneElement);
+    connect(m_scene, &Scene::sceneChanged, this, &ScreenplayElement::sceneContentChanged);
 
     if (m_screenplay)
         connect(m_scene->heading(), &SceneHeading::enabledChanged, this,
@@ -1509,6 +1514,10 @@ void Screenplay::clearElements()
         GarbageCollector::instance()->add(ptr);
     }
 
+    m_searchIndex.clear();
+    m_searchIndexDirtyScenes.clear();
+    m_searchIndexScenesChanged = false;
+
     this->endResetModel();
 
     emit elementCountChanged();
@@ -2134,6 +2143,17 @@ void Screenplay::connectToScreenplayElementSignals(ScreenplayElement *ptr)
             Qt::UniqueConnection);
     connect(ptr, &ScreenplayElement::heightHintChanged, this,
             &Screenplay::evaluateIfHeightHintsAreAvailableLater, Qt::UniqueConnection);
+    connect(ptr, &ScreenplayElement::sceneElementChanged, this, &Screenplay::onSceneElementChanged,
+            Qt::UniqueConnection);
+    connect(ptr, &ScreenplayElement::aboutToRemoveSceneElement, this,
+            &Screenplay::onAboutToRemoveSceneElement, Qt::UniqueConnection);
+    connect(ptr, &ScreenplayElement::sceneContentChanged, this,
+            &Screenplay::onSceneContentChanged, Qt::UniqueConnection);
+    connect(ptr, &ScreenplayElement::sceneChanged, this, &Screenplay::onSceneContentChanged,
+            Qt::UniqueConnection);
+
+    if (ptr->scene() != nullptr)
+        m_searchIndexDirtyScenes += ptr->scene();
 }
 
 void Screenplay::disconnectFromScreenplayElementSignals(ScreenplayElement *ptr)
@@ -2159,6 +2179,79 @@ void Screenplay::disconnectFromScreenplayElementSignals(ScreenplayElement *ptr)
                &Screenplay::hasSelectedElementsChanged);
     disconnect(ptr, &ScreenplayElement::heightHintChanged, this,
                &Screenplay::evaluateIfHeightHintsAreAvailableLater);
+    disconnect(ptr, &ScreenplayElement::sceneElementChanged, this,
+               &Screenplay::onSceneElementChanged);
+    disconnect(ptr, &ScreenplayElement::aboutToRemoveSceneElement, this,
+               &Screenplay::onAboutToRemoveSceneElement);
+    disconnect(ptr, &ScreenplayElement::sceneContentChanged, this,
+               &Screenplay::onSceneContentChanged);
+    disconnect(ptr, &ScreenplayElement::sceneChanged, this, &Screenplay::onSceneContentChanged);
+
+    // Scene of this element may no longer be in the screenplay.
+    m_searchIndexScenesChanged = true;
+}
+
+void Screenplay::onSceneElementChanged(SceneElement *element, Scene::SceneElementChangeType type)
+{
+    if (type == Scene::ElementTextChange)
+        m_searchIndex.update(element->scene(), element, ScreenplaySearchResult::SceneElementText,
+                             element->text());
+}
+
+void Screenplay::onAboutToRemoveSceneElement(SceneElement *element)
+{
+    m_searchIndex.remove(element, ScreenplaySearchResult::SceneElementText);
+}
+
+void Screenplay::onSceneContentChanged()
+{
+    ScreenplayElement *element = qobject_cast<ScreenplayElement *>(this->sender());
+    if (element != nullptr && element->scene() != nullptr)
+        m_searchIndexDirtyScenes += element->scene();
+}
+
+void Screenplay::updateSearchIndex() const
+{
+    if (m_searchIndexDirtyScenes.isEmpty() && !m_searchIndexScenesChanged)
+        return;
+
+    QSet<const QObject *> scenes;
+    for (ScreenplayElement *element : m_elements) {
+        if (element->scene() != nullptr)
+            scenes += element->scene();
+    }
+
+    if (m_searchIndexScenesChanged) {
+        m_searchIndex.retainGroups(scenes);
+        m_searchIndexScenesChanged = false;
+    }
+
+    // Dirty scenes may have been deleted since, so they are looked at only if they are
+    // still in the screenplay.
+    for (const Scene *scene : qAsConst(m_searchIndexDirtyScenes)) {
+        if (!scenes.contains(scene))
+            continue;
+
+        const int nrElements = scene->elementCount();
+        for (int j = 0; j < nrElements; j++) {
+            const SceneElement *para = scene->elementAt(j);
+            m_searchIndex.update(scene, para, ScreenplaySearchResult::SceneElementText,
+                                 para->text());
+        }
+
+        const Notes *notes = scene->notes();
+        const int nrNotes = notes ? notes->noteCount() : 0;
+        for (int n = 0; n < nrNotes; n++) {
+            const Note *note = notes->noteAt(n);
+            m_searchIndex.update(scene, note, ScreenplaySearchResult::NoteTitle, note->title());
+            m_searchIndex.update(scene, note, ScreenplaySearchResult::NoteSummary,
+                                 note->summary());
+        }
+
+        m_searchIndex.sweep(scene);
+    }
+
+    m_searchIndexDirtyScenes.clear();
 }
 
 void Screenplay::setWordCount(int val)
@@ -2349,40 +2442,17 @@ void Screenplay::setActiveScene(Scene *val)
 
 QJsonArray Screenplay::search(const QString &text, int flags) const
 {
-    HourGlass hourGlass;
-
     QJsonArray ret;
 
-    const int nrScenes = m_elements.size();
-    for (int i = 0; i < nrScenes; i++) {
-        Scene *scene = m_elements.at(i)->scene();
-        if (scene == nullptr)
-            continue;
-
-        int sceneResultIndex = 0;
-
-        const int nrElements = scene->elementCount();
-        for (int j = 0; j < nrElements; j++) {
-            SceneElement *element = scene->elementAt(j);
-
-            const QJsonArray results = element->find(text, flags);
-            if (!results.isEmpty()) {
-                for (int r = 0; r < results.size(); r++) {
-                    const QJsonObject result = results.at(r).toObject();
-
-                    QJsonObject item;
-                    item.insert(QStringLiteral("sceneIndex"), i);
-                    item.insert(QStringLiteral("elementIndex"), j);
-                    item.insert(QStringLiteral("sceneResultIndex"), sceneResultIndex++);
-
-                    const QString _from = QStringLiteral("from");
-                    const QString _to = QStringLiteral("to");
-                    item.insert(_from, _from);
-                    item.insert(_to, _to);
-                    ret.append(item);
-                }
-            }
-        }
+    const QVector<ScreenplaySearchResult> results = this->findAll(text, flags);
+    for (const ScreenplaySearchResult &result : results) {
+        QJsonObject item;
+        item.insert(QStringLiteral("sceneIndex"), result.sceneIndex);
+        item.insert(QStringLiteral("elementIndex"), result.elementIndex);
+        item.insert(QStringLiteral("sceneResultIndex"), result.sceneResultIndex);
+        item.insert(QStringLiteral("from"), result.from);
+        item.insert(QStringLiteral("to"), result.to);
+        ret.append(item);
     }
 
     return ret;
@@ -2392,24 +2462,39 @@ int Screenplay::replace(const QString &text, const QString &replacementText, int
 {
     HourGlass hourGlass;
 
+    const QVector<ScreenplaySearchResult> results = this->findAll(text, flags);
+    if (results.isEmpty())
+        return 0;
+
     int counter = 0;
 
-    const int nrScenes = m_elements.size();
-    for (int i = 0; i < nrScenes; i++) {
-        Scene *scene = m_elements.at(i)->scene();
-        if (scene == nullptr)
-            continue;
+    // A scene can show up more than once in the screenplay, but its paragraphs must be
+    // replaced in only once.
+    QSet<SceneElement *> replacedElements;
+
+    int r = 0;
+    while (r < results.size()) {
+        const int sceneIndex = results.at(r).sceneIndex;
+        Scene *scene = m_elements.at(sceneIndex)->scene();
 
         bool begunUndoCapture = false;
 
-        const int nrElements = scene->elementCount();
-        for (int j = 0; j < nrElements; j++) {
-            SceneElement *element = scene->elementAt(j);
-            const QJsonArray results = element->find(text, flags);
-            counter += results.size();
+        while (r < results.size() && results.at(r).sceneIndex == sceneIndex) {
+            const int elementIndex = results.at(r).elementIndex;
+
+            int end = r;
+            while (end < results.size() && results.at(end).sceneIndex == sceneIndex
+                   && results.at(end).elementIndex == elementIndex)
+                ++end;
 
-            if (results.isEmpty())
+            SceneElement *element = scene->elementAt(elementIndex);
+            if (replacedElements.contains(element)) {
+                r = end;
                 continue;
+            }
+
+            replacedElements.insert(element);
+            counter += end - r;
 
             if (!begunUndoCapture) {
                 scene->beginUndoCapture();
@@ -2417,16 +2502,14 @@ int Screenplay::replace(const QString &text, const QString &replacementText, int
             }
 
             QString elementText = element->text();
-            for (int r = results.size() - 1; r >= 0; r--) {
-                const QString _from = QStringLiteral("from");
-                const QString _to = QStringLiteral("to");
-                const QJsonObject result = results.at(r).toObject();
-                const int from = result.value(_from).toInt();
-                const int to = result.value(_to).toInt();
-                elementText = elementText.replace(from, to - from + 1, replacementText);
+            for (int i = end - 1; i >= r; i--) {
+                const ScreenplaySearchResult &result = results.at(i);
+                elementText = elementText.replace(result.from, result.to - result.from + 1,
+                                                  replacementText);
             }
 
             element->setText(elementText);
+            r = end;
         }
 
         if (begunUndoCapture)
@@ -2436,6 +2519,82 @@ int Screenplay::replace(const QString &text, const QString &replacementText, int
     return counter;
 }
 
+QVector<ScreenplaySearchResult> Screenplay::findAll(const QString &text, int flags,
+                                                    bool includeNotes) const
+{
+    QVector<ScreenplaySearchResult> ret;
+    if (text.isEmpty())
+        return ret;
+
+    this->updateSearchIndex();
+
+    QSet<ScreenplaySearchIndex::Key> candidates;
+    QSet<const QObject *> candidateScenes;
+    const bool narrowed = m_searchIndex.candidates(text, &candidates, &candidateScenes);
+    if (narrowed && candidates.isEmpty())
+        return ret;
+
+    auto isCandidate = [&](const QObject *object, ScreenplaySearchResult::Source source) {
+        return !narrowed || candidates.contains(ScreenplaySearchIndex::Key(object, source));
+    };
+
+    const int nrScenes = m_elements.size();
+    for (int i = 0; i < nrScenes; i++) {
+        const Scene *scene = m_elements.at(i)->scene();
+        if (scene == nullptr || (narrowed && !candidateScenes.contains(scene)))
+            continue;
+
+        int sceneResultIndex = 0;
+
+        const int nrElements = scene->elementCount();
+        for (int j = 0; j < nrElements; j++) {
+            const SceneElement *para = scene->elementAt(j);
+            if (!isCandidate(para, ScreenplaySearchResult::SceneElementText))
+                continue;
+
+            const QVector<QPair<int, int>> ranges =
+                    SearchEngine::matchRanges(text, para->text(), flags);
+            for (const QPair<int, int> &range : ranges) {
+                ScreenplaySearchResult result;
+                result.sceneIndex = i;
+                result.elementIndex = j;
+                result.sceneResultIndex = sceneResultIndex++;
+                result.from = range.first;
+                result.to = range.second;
+                ret.append(result);
+            }
+        }
+
+        const Notes *notes = includeNotes ? scene->notes() : nullptr;
+        const int nrNotes = notes ? notes->noteCount() : 0;
+        for (int n = 0; n < nrNotes; n++) {
+            Note *note = notes->noteAt(n);
+            for (const ScreenplaySearchResult::Source source :
+                 { ScreenplaySearchResult::NoteTitle, ScreenplaySearchResult::NoteSummary }) {
+                if (!isCandidate(note, source))
+                    continue;
+
+                const QString noteText = source == ScreenplaySearchResult::NoteTitle
+                        ? note->title()
+                        : note->summary();
+                const QVector<QPair<int, int>> ranges =
+                        SearchEngine::matchRanges(text, noteText, flags);
+                for (const QPair<int, int> &range : ranges) {
+                    ScreenplaySearchResult result;
+                    result.source = source;
+                    result.sceneIndex = i;
+                    result.note = note;
+                    result.from = range.first;
+                    result.to = range.second;
+                    ret.append(result);
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
 void Screenplay::resetSceneNumbers()
 {
     this->evaluateSceneNumbers(true);
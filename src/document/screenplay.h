@@ -18,6 +18,7 @@
 #include "modifiable.h"
 #include "execlatertimer.h"
 #include "qobjectproperty.h"
+#include "screenplaysearchindex.h"
 
 #include <QJsonArray>
 #include <QJsonValue>
@@ -162,6 +163,10 @@ public:
     Q_SIGNAL void evaluateSceneNumberRequest();
     Q_SIGNAL void sceneTypeChanged();
     Q_SIGNAL void sceneGroupsChanged(ScreenplayElement *ptr);
+    Q_SIGNAL void sceneElementChanged(SceneElement *element,
+                                      Scene::SceneElementChangeType type);
+    Q_SIGNAL void aboutToRemoveSceneElement(SceneElement *element);
+    Q_SIGNAL void sceneContentChanged();
 
     // QObjectSerializer::Interface interface
     bool canSerialize(const QMetaObject *, const QMetaProperty &) const;
@@ -239,6 +244,21 @@ private:
     QObjectProperty<Screenplay> m_screenplay;
 };
 
+struct ScreenplaySearchResult
+{
+    enum Source { SceneElementText, NoteTitle, NoteSummary };
+    Source source = SceneElementText;
+
+    int sceneIndex = -1; // index of the ScreenplayElement
+    int elementIndex = -1; // index of the SceneElement, -1 for notes
+    int sceneResultIndex = -1; // index among matches in the scene, -1 for notes
+    Note *note = nullptr;
+
+    // Matched range in the text, as with SearchEngine::matchRanges() 'to' is inclusive
+    int from = -1;
+    int to = -1;
+};
+
 class Screenplay : public QAbstractListModel, public Modifiable, public QObjectSerializer::Interface
 {
     Q_OBJECT
@@ -452,6 +472,8 @@ public:
 
     Q_INVOKABLE QJsonArray search(const QString &text, int flags = 0) const;
     Q_INVOKABLE int replace(const QString &text, const QString &replacementText, int flags = 0);
+    QVector<ScreenplaySearchResult> findAll(const QString &text, int flags = 0,
+                                            bool includeNotes = false) const;
 
     Q_PROPERTY(int minimumParagraphCount READ minimumParagraphCount NOTIFY paragraphCountChanged)
     int minimumParagraphCount() const { return m_minimumParagraphCount; }
@@ -534,6 +556,10 @@ protected:
     void setHeightHintsAvailable(bool val);
     void evaluateIfHeightHintsAreAvailable();
     void evaluateIfHeightHintsAreAvailableLater();
+    void onSceneElementChanged(SceneElement *element, Scene::SceneElementChangeType type);
+    void onAboutToRemoveSceneElement(SceneElement *element);
+    void onSceneContentChanged();
+    void updateSearchIndex() const;
 
 private:
     QString m_title;
@@ -576,6 +602,13 @@ private:
     int m_sceneCount = 0;
     int m_wordCount = 0;
 
+    // Paragraphs are re-indexed as they are edited. Scenes whose paragraphs or notes change
+    // in any other way are re-indexed as a whole before the next search. Scenes that were
+    // removed from the screenplay are dropped from the index then as well.
+    mutable ScreenplaySearchIndex m_searchIndex;
+    mutable QSet<const Scene *> m_searchIndexDirtyScenes;
+    mutable bool m_searchIndexScenesChanged = false;
+
     ExecLaterTimer m_wordCountTimer;
     ExecLaterTimer m_updateBreakTitlesTimer;
     ExecLaterTimer m_sceneNumberEvaluationTimer;
@@ -0,0 +1,229 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "screenplaylayoutmetrics.h"
+
+#include "formatting.h"
+#include "transliteration.h"
+
+#include <QSet>
+#include <QCache>
+#include <QtMath>
+#include <QDataStream>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QCryptographicHash>
+#include <QAbstractTextDocumentLayout>
+
+// Roughly 40 feature length screenplays worth of paragraphs
+typedef QCache<QPair<QByteArray, QString>, qreal> ScreenplayLayoutHeightCache;
+Q_GLOBAL_STATIC_WITH_ARGS(ScreenplayLayoutHeightCache, HeightCache, (50000))
+
+ScreenplayLayoutMetrics::ScreenplayLayoutMetrics(const ScreenplayFormat *format)
+    : m_format(format)
+{
+    if (m_format == nullptr)
+        return;
+
+    m_pageWidth = qCeil(m_format->pageLayout()->contentWidth());
+    m_pageHeight = qCeil(m_format->pageLayout()->contentRect().height());
+
+    // Everything other than block and char formats that changes how text is laid out.
+    QDataStream ds(&m_fontKey, QIODevice::WriteOnly);
+    ds << m_pageWidth << m_format->defaultFont().toString();
+
+    TransliterationEngine *engine = TransliterationEngine::instance();
+    for (int i = TransliterationEngine::English; i <= TransliterationEngine::Telugu; i++)
+        ds << engine->preferredFontFamilyForLanguage(TransliterationEngine::Language(i));
+}
+
+ScreenplayLayoutMetrics::~ScreenplayLayoutMetrics() { }
+
+void ScreenplayLayoutMetrics::prefetch(const QList<const Scene *> &scenes)
+{
+    if (m_format == nullptr)
+        return;
+
+    QSet<Key> keys;
+    QVector<Paragraph> paras;
+    auto include = [&](SceneElement::Type type, Qt::Alignment alignment, const QString &text) {
+        Paragraph para;
+        para.key = this->key(type, alignment, text);
+        if (::HeightCache->contains(para.key) || keys.contains(para.key))
+            return;
+
+        para.type = type;
+        para.alignment = alignment;
+        keys.insert(para.key);
+        paras.append(para);
+    };
+
+    for (const Scene *scene : scenes) {
+        if (scene == nullptr)
+            continue;
+
+        if (scene->heading()->isEnabled())
+            include(SceneElement::Heading, Qt::Alignment(), scene->heading()->text());
+
+        for (int i = 0; i < scene->elementCount(); i++) {
+            const SceneElement *para = scene->elementAt(i);
+            include(para->type(), para->alignment(), para->text());
+        }
+    }
+
+    this->measure(paras);
+}
+
+qreal ScreenplayLayoutMetrics::height(const SceneHeading *heading)
+{
+    if (heading == nullptr || !heading->isEnabled())
+        return 0;
+
+    return this->height(SceneElement::Heading, Qt::Alignment(), heading->text());
+}
+
+qreal ScreenplayLayoutMetrics::height(const SceneElement *para)
+{
+    if (para == nullptr)
+        return 0;
+
+    return this->height(para->type(), para->alignment(), para->text());
+}
+
+qreal ScreenplayLayoutMetrics::margins(const SceneHeading *heading)
+{
+    if (m_format == nullptr || heading == nullptr || !heading->isEnabled())
+        return 0;
+
+    return this->format(SceneElement::Heading, Qt::Alignment()).margins;
+}
+
+qreal ScreenplayLayoutMetrics::margins(const SceneElement *para)
+{
+    if (m_format == nullptr || para == nullptr)
+        return 0;
+
+    return this->format(para->type(), para->alignment()).margins;
+}
+
+qreal ScreenplayLayoutMetrics::height(const Scene *scene)
+{
+    if (scene == nullptr)
+        return 0;
+
+    this->prefetch(QList<const Scene *>({ scene }));
+
+    qreal ret = this->height(scene->heading()) + this->margins(scene->heading());
+    for (int i = 0; i < scene->elementCount(); i++) {
+        const SceneElement *para = scene->elementAt(i);
+        ret += this->height(para) + this->margins(para);
+    }
+
+    return ret;
+}
+
+qreal ScreenplayLayoutMetrics::pageLength(qreal height) const
+{
+    return qFuzzyIsNull(m_pageHeight) ? 0 : height / m_pageHeight;
+}
+
+void ScreenplayLayoutMetrics::clearCache()
+{
+    ::HeightCache->clear();
+}
+
+const ScreenplayLayoutMetrics::Format &ScreenplayLayoutMetrics::format(SceneElement::Type type,
+                                                                      Qt::Alignment alignment)
+{
+    const QPair<int, int> formatId(int(type), int(alignment));
+
+    auto it = m_formats.find(formatId);
+    if (it == m_formats.end()) {
+        const SceneElementFormat *eformat = m_format->elementFormat(type);
+        const QTextBlockFormat blockFormat = eformat->createBlockFormat(alignment, &m_pageWidth);
+
+        QByteArray bytes = m_fontKey;
+        QDataStream ds(&bytes, QIODevice::Append);
+        ds << blockFormat << eformat->createCharFormat(&m_pageWidth);
+
+        Format format;
+        format.hash = QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+        format.margins = blockFormat.topMargin() + blockFormat.bottomMargin();
+        it = m_formats.insert(formatId, format);
+    }
+
+    return it.value();
+}
+
+ScreenplayLayoutMetrics::Key ScreenplayLayoutMetrics::key(SceneElement::Type type,
+                                                          Qt::Alignment alignment,
+                                                          const QString &text)
+{
+    return Key(this->format(type, alignment).hash, text);
+}
+
+qreal ScreenplayLayoutMetrics::height(SceneElement::Type type, Qt::Alignment alignment,
+                                      const QString &text)
+{
+    if (m_format == nullptr)
+        return 0;
+
+    Paragraph para;
+    para.key = this->key(type, alignment, text);
+    if (const qreal *height = ::HeightCache->object(para.key))
+        return *height;
+
+    para.type = type;
+    para.alignment = alignment;
+    this->measure(QVector<Paragraph>({ para }));
+
+    const qreal *height = ::HeightCache->object(para.key);
+    return height ? *height : 0;
+}
+
+void ScreenplayLayoutMetrics::measure(const QVector<Paragraph> &paras)
+{
+    if (paras.isEmpty())
+        return;
+
+    // Same document setup and paragraph formats as printed screenplays.
+    QTextDocument document;
+    document.setUseDesignMetrics(true);
+    document.setTextWidth(m_pageWidth);
+    document.setDefaultFont(m_format->defaultFont());
+
+    const TransliterationEngine *engine = TransliterationEngine::instance();
+
+    QVector<QTextBlock> blocks;
+    blocks.reserve(paras.size());
+
+    QTextCursor cursor(&document);
+    for (const Paragraph &para : paras) {
+        // Every paragraph gets a block of its own, even if the one before it is empty.
+        if (!blocks.isEmpty())
+            cursor.insertBlock();
+
+        const SceneElementFormat *eformat = m_format->elementFormat(para.type);
+        cursor.setCharFormat(eformat->createCharFormat(&m_pageWidth));
+        cursor.setBlockFormat(eformat->createBlockFormat(para.alignment, &m_pageWidth));
+        engine->evaluateBoundariesAndInsertText(cursor, para.key.second);
+
+        blocks.append(cursor.block());
+    }
+
+    QAbstractTextDocumentLayout *layout = document.documentLayout();
+    for (int i = 0; i < paras.size(); i++) {
+        const qreal height = qMax(layout->blockBoundingRect(blocks.at(i)).height(), 0.0);
+        ::HeightCache->insert(paras.at(i).key, new qreal(height));
+    }
+}
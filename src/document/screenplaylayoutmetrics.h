@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef SCREENPLAYLAYOUTMETRICS_H
+#define SCREENPLAYLAYOUTMETRICS_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+
+#include "scene.h"
+
+class ScreenplayFormat;
+
+/**
+ * Heights of scene headings and paragraphs, as they would be laid out on a page of the
+ * given screenplay format.
+ *
+ * Heights are cached across instances, against the text of a paragraph and a hash of
+ * everything that goes into laying it out: block and char formats, page width and fonts.
+ * Reports generated one after the other only lay out paragraphs edited in between, and
+ * a change of format simply misses the cache.
+ *
+ * Paragraphs are measured one at a time, in isolation, and their heights simply add up.
+ * QTextDocument collapses the bottom margin of a paragraph with the top margin of the next
+ * one, so sums match its layout only because paragraph formats set top margins alone.
+ * Use only from the GUI thread.
+ */
+class ScreenplayLayoutMetrics
+{
+public:
+    explicit ScreenplayLayoutMetrics(const ScreenplayFormat *format);
+    ~ScreenplayLayoutMetrics();
+
+    qreal pageWidth() const { return m_pageWidth; }
+    qreal pageHeight() const { return m_pageHeight; }
+
+    // Lays out all paragraphs of these scenes that are not in the cache yet, in one go.
+    // Optional, heights are otherwise measured as they are asked for.
+    void prefetch(const QList<const Scene *> &scenes);
+
+    // Height of text in the paragraph, without its margins
+    qreal height(const SceneHeading *heading);
+    qreal height(const SceneElement *para);
+
+    // Top and bottom margins of the paragraph, together
+    qreal margins(const SceneHeading *heading);
+    qreal margins(const SceneElement *para);
+
+    // Height of the heading (if enabled) and all paragraphs of the scene, with margins
+    qreal height(const Scene *scene);
+
+    qreal pageLength(qreal height) const;
+
+    static void clearCache();
+
+private:
+    typedef QPair<QByteArray, QString> Key;
+
+    struct Format
+    {
+        QByteArray hash;
+        qreal margins = 0;
+    };
+
+    struct Paragraph
+    {
+        Key key;
+        SceneElement::Type type = SceneElement::Action;
+        Qt::Alignment alignment;
+    };
+
+    const Format &format(SceneElement::Type type, Qt::Alignment alignment);
+    Key key(SceneElement::Type type, Qt::Alignment alignment, const QString &text);
+    qreal height(SceneElement::Type type, Qt::Alignment alignment, const QString &text);
+    void measure(const QVector<Paragraph> &paras);
+
+private:
+    qreal m_pageWidth = 0;
+    qreal m_pageHeight = 0;
+    QByteArray m_fontKey;
+    const ScreenplayFormat *m_format = nullptr;
+    QHash<QPair<int, int>, Format> m_formats;
+};
+
+#endif // SCREENPLAYLAYOUTMETRICS_H
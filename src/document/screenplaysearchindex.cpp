@@ -0,0 +1,245 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "screenplaysearchindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+/**
+ * Returns sorted, unique trigrams of text. Each trigram packs three case-folded UTF-16 code
+ * units into the lower 48 bits of a quint64, the same units that a case-insensitive
+ * QString::indexOf() compares.
+ */
+static QVector<quint64> Trigrams(const QString &text)
+{
+    QVector<quint64> ret;
+
+    const int length = text.length();
+    if (length < 3)
+        return ret;
+
+    ret.reserve(length - 2);
+
+    quint64 trigram = 0;
+    for (int i = 0; i < length; i++) {
+        trigram = ((trigram << 16) | text.at(i).toCaseFolded().unicode())
+                & Q_UINT64_C(0xFFFFFFFFFFFF);
+        if (i >= 2)
+            ret.append(trigram);
+    }
+
+    std::sort(ret.begin(), ret.end());
+    ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+    return ret;
+}
+
+ScreenplaySearchIndex::ScreenplaySearchIndex() { }
+
+ScreenplaySearchIndex::~ScreenplaySearchIndex() { }
+
+void ScreenplaySearchIndex::update(const QObject *group, const QObject *object, int field,
+                                   const QString &text)
+{
+    if (object == nullptr)
+        return;
+
+    const Key key(object, field);
+
+    auto it = m_slotMap.find(key);
+    if (it == m_slotMap.end()) {
+        int slot = -1;
+        if (m_freeSlots.isEmpty()) {
+            slot = m_entries.size();
+            m_entries.append(Entry());
+        } else
+            slot = m_freeSlots.takeLast();
+
+        Entry &entry = m_entries[slot];
+        entry.key = key;
+        entry.group = group;
+        entry.text = text;
+        entry.generation = m_generation;
+        entry.trigrams = ::Trigrams(text);
+        this->addPostings(slot, entry.trigrams);
+
+        m_slotMap.insert(key, slot);
+        m_groupSlots[group].insert(slot);
+        return;
+    }
+
+    const int slot = it.value();
+    Entry &entry = m_entries[slot];
+    entry.generation = m_generation;
+
+    // Objects can move from one group to another, for instance when a paragraph is cut
+    // from one scene and pasted into another.
+    if (entry.group != group) {
+        auto git = m_groupSlots.find(entry.group);
+        if (git != m_groupSlots.end()) {
+            git.value().remove(slot);
+            if (git.value().isEmpty())
+                m_groupSlots.erase(git);
+        }
+
+        entry.group = group;
+        m_groupSlots[group].insert(slot);
+    }
+
+    // Same text data as last time, which is the case for most texts when a group is
+    // re-indexed.
+    if (entry.text.constData() == text.constData() && entry.text.length() == text.length())
+        return;
+
+    if (entry.text == text) {
+        entry.text = text;
+        return;
+    }
+
+    const QVector<quint64> trigrams = ::Trigrams(text);
+
+    QVector<quint64> lost, gained;
+    std::set_difference(entry.trigrams.begin(), entry.trigrams.end(), trigrams.begin(),
+                        trigrams.end(), std::back_inserter(lost));
+    std::set_difference(trigrams.begin(), trigrams.end(), entry.trigrams.begin(),
+                        entry.trigrams.end(), std::back_inserter(gained));
+
+    this->removePostings(slot, lost);
+    this->addPostings(slot, gained);
+
+    entry.text = text;
+    entry.trigrams = trigrams;
+}
+
+void ScreenplaySearchIndex::remove(const QObject *object, int field)
+{
+    const auto it = m_slotMap.constFind(Key(object, field));
+    if (it != m_slotMap.constEnd())
+        this->removeSlot(it.value());
+}
+
+void ScreenplaySearchIndex::clear()
+{
+    m_entries.clear();
+    m_freeSlots.clear();
+    m_slotMap.clear();
+    m_groupSlots.clear();
+    m_postings.clear();
+}
+
+void ScreenplaySearchIndex::sweep(const QObject *group)
+{
+    const auto it = m_groupSlots.constFind(group);
+    if (it != m_groupSlots.constEnd()) {
+        QList<int> staleSlots;
+        for (const int slot : it.value()) {
+            if (m_entries.at(slot).generation != m_generation)
+                staleSlots.append(slot);
+        }
+
+        for (const int slot : qAsConst(staleSlots))
+            this->removeSlot(slot);
+    }
+
+    ++m_generation;
+}
+
+void ScreenplaySearchIndex::retainGroups(const QSet<const QObject *> &groups)
+{
+    QList<int> staleSlots;
+    for (auto it = m_groupSlots.constBegin(), end = m_groupSlots.constEnd(); it != end; ++it) {
+        if (!groups.contains(it.key()))
+            staleSlots += it.value().values();
+    }
+
+    for (const int slot : qAsConst(staleSlots))
+        this->removeSlot(slot);
+}
+
+bool ScreenplaySearchIndex::candidates(const QString &text, QSet<Key> *keys,
+                                       QSet<const QObject *> *groups) const
+{
+    const QVector<quint64> trigrams = ::Trigrams(text);
+    if (trigrams.isEmpty())
+        return false;
+
+    // Walk the shortest postings list, checking other trigrams of the text against
+    // trigrams of each entry in it.
+    const QVector<int> *shortest = nullptr;
+    for (const quint64 trigram : trigrams) {
+        auto it = m_postings.constFind(trigram);
+        if (it == m_postings.constEnd())
+            return true;
+
+        if (shortest == nullptr || it.value().size() < shortest->size())
+            shortest = &it.value();
+    }
+
+    for (const int slot : *shortest) {
+        const Entry &entry = m_entries.at(slot);
+        const bool hasAllTrigrams =
+                std::all_of(trigrams.begin(), trigrams.end(), [&entry](quint64 trigram) {
+                    return std::binary_search(entry.trigrams.begin(), entry.trigrams.end(),
+                                              trigram);
+                });
+        if (hasAllTrigrams) {
+            keys->insert(entry.key);
+            if (groups)
+                groups->insert(entry.group);
+        }
+    }
+
+    return true;
+}
+
+void ScreenplaySearchIndex::addPostings(int slot, const QVector<quint64> &trigrams)
+{
+    for (const quint64 trigram : trigrams)
+        m_postings[trigram].append(slot);
+}
+
+void ScreenplaySearchIndex::removePostings(int slot, const QVector<quint64> &trigrams)
+{
+    for (const quint64 trigram : trigrams) {
+        auto it = m_postings.find(trigram);
+        if (it == m_postings.end())
+            continue;
+
+        QVector<int> &slots = it.value();
+        const int index = slots.indexOf(slot);
+        if (index >= 0) {
+            slots[index] = slots.last();
+            slots.removeLast();
+        }
+
+        if (slots.isEmpty())
+            m_postings.erase(it);
+    }
+}
+
+void ScreenplaySearchIndex::removeSlot(int slot)
+{
+    Entry &entry = m_entries[slot];
+    m_slotMap.remove(entry.key);
+
+    auto it = m_groupSlots.find(entry.group);
+    if (it != m_groupSlots.end()) {
+        it.value().remove(slot);
+        if (it.value().isEmpty())
+            m_groupSlots.erase(it);
+    }
+
+    this->removePostings(slot, entry.trigrams);
+    entry = Entry();
+    m_freeSlots.append(slot);
+}
@@ -0,0 +1,89 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef SCREENPLAYSEARCHINDEX_H
+#define SCREENPLAYSEARCHINDEX_H
+
+#include <QSet>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class QObject;
+
+/**
+ * Inverted index of case-folded trigrams in texts of a screenplay, so that searches only
+ * have to look at paragraphs (and notes) which can possibly contain the search string.
+ *
+ * Texts are indexed against an (object, field) key, within a group (a scene) that owns the
+ * object. Updating a key with the QString it was last indexed with costs nothing. Otherwise
+ * only trigrams gained or lost by the edit touch the postings, which keeps re-indexing a
+ * paragraph on every keystroke cheap.
+ *
+ * The index is case-insensitive and knows nothing about word boundaries. Candidates it
+ * returns must be verified against their text to honour search flags.
+ */
+class ScreenplaySearchIndex
+{
+public:
+    ScreenplaySearchIndex();
+    ~ScreenplaySearchIndex();
+
+    typedef QPair<const QObject *, int> Key;
+
+    void update(const QObject *group, const QObject *object, int field, const QString &text);
+    void remove(const QObject *object, int field);
+    void clear();
+
+    int size() const { return m_slotMap.size(); }
+
+    // Removes keys of the group that were not updated since the previous sweep. Index users
+    // re-index a group by updating all texts in it and then sweeping it, so that keys of
+    // objects no longer in the group don't linger.
+    void sweep(const QObject *group);
+
+    // Removes keys of all groups other than the given ones. Pointers to groups are never
+    // dereferenced, so groups that have been deleted can be dropped this way.
+    void retainGroups(const QSet<const QObject *> &groups);
+
+    // Collects keys whose text may contain the given text into keys, and their groups into
+    // groups. Returns false if text is too short to narrow down candidates, in which case
+    // every key is one.
+    bool candidates(const QString &text, QSet<Key> *keys,
+                    QSet<const QObject *> *groups = nullptr) const;
+
+private:
+    struct Entry
+    {
+        Key key;
+        const QObject *group = nullptr;
+        QString text;
+        int generation = 0;
+        QVector<quint64> trigrams; // sorted, unique
+    };
+
+    void addPostings(int slot, const QVector<quint64> &trigrams);
+    void removePostings(int slot, const QVector<quint64> &trigrams);
+    void removeSlot(int slot);
+
+private:
+    QVector<Entry> m_entries;
+    QVector<int> m_freeSlots;
+    QHash<Key, int> m_slotMap;
+    QHash<const QObject *, QSet<int>> m_groupSlots;
+    int m_generation = 0;
+    QHash<quint64, QVector<int>> m_postings;
+};
+
+#endif // SCREENPLAYSEARCHINDEX_H
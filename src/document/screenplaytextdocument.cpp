@@ -20,6 +20,7 @@
 #include "scritedocument.h"
 #include "garbagecollector.h"
 #include "screenplaytextdocument.h"
+#include "qtextdocumentpagerecorder.h"
 #include "pdfexportablegraphicsscene.h"
 
 #include <QDir>
@@ -3000,7 +3001,6 @@ void ScreenplayElementPageBreaks::setPageBreaks(const QJsonArray &val)
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-Q_DECL_IMPORT int qt_defaultDpi();
 
 ScreenplayTitlePageObjectInterface::ScreenplayTitlePageObjectInterface(QObject *parent)
     : QObject(parent)
@@ -3244,7 +3244,13 @@ void ScreenplayTitlePageObjectInterface::drawObject(QPainter *painter, const QRe
 
 ///////////////////////////////////////////////////////////////////////////////
 
-ScreenplayTextObjectInterface::ScreenplayTextObjectInterface(QObject *parent) : QObject(parent) { }
+ScreenplayTextObjectInterface::ScreenplayTextObjectInterface(QObject *parent) : QObject(parent)
+{
+    // Scene numbers, markers and icons are drawn from the text format alone, so
+    // QTextDocumentPageRecorder can draw them on its worker threads. Text is scaled for the
+    // device pages are printed on, not for the QPicture they are recorded into, see drawText().
+    this->setProperty("#threadSafeDrawing", true);
+}
 
 ScreenplayTextObjectInterface::~ScreenplayTextObjectInterface() { }
 
@@ -3302,7 +3308,7 @@ void ScreenplayTextObjectInterface::drawSceneNumber(QPainter *painter, const QRe
     rect.setLeft(rect.left() * 0.55);
 
     const QString sceneNumberText = sceneNumber + QStringLiteral(".");
-    this->drawText(painter, rect, sceneNumberText);
+    this->drawText(painter, rect, sceneNumberText, doc);
 }
 
 void ScreenplayTextObjectInterface::drawMoreMarker(QPainter *painter, const QRectF &givenRect,
@@ -3326,7 +3332,7 @@ void ScreenplayTextObjectInterface::drawMoreMarker(QPainter *painter, const QRec
     QColor textColor = format.foreground().color();
     textColor.setAlphaF(textColor.alphaF() * 0.75);
     painter->setPen(textColor);
-    this->drawText(painter, rect, text);
+    this->drawText(painter, rect, text, doc);
 
     painter->setPen(oldPen);
 }
@@ -3374,26 +3380,27 @@ void ScreenplayTextObjectInterface::drawSceneIcon(QPainter *painter, const QRect
     iconKeyRect.moveTop(rect.bottom() + rect.height() * 0.5);
     painter->save();
     painter->setFont(QFont(painter->font().family(), painter->font().pointSize() - 4));
-    this->drawText(painter, iconKeyRect, QStringLiteral("(") + iconKey + QStringLiteral(")"));
+    this->drawText(painter, iconKeyRect, QStringLiteral("(") + iconKey + QStringLiteral(")"),
+                   doc);
     painter->restore();
 }
 
 void ScreenplayTextObjectInterface::drawText(QPainter *painter, const QRectF &rect,
-                                             const QString &text)
+                                             const QString &text, const QTextDocument *doc)
 {
-    const bool isPdfDevice = painter->device()->paintEngine()->type() == QPaintEngine::Pdf;
-
-    if (isPdfDevice) {
-        const qreal invScaleX = qreal(qt_defaultDpi()) / painter->device()->logicalDpiX();
-        const qreal invScaleY = qreal(qt_defaultDpi()) / painter->device()->logicalDpiY();
+    // The painter's device is a QPicture while QTextDocumentPageRecorder records pages of
+    // doc, so only the recorder knows what the text is going to be printed on.
+    const QSizeF scale = QTextDocumentPageRecorder::textScale(doc, painter->device());
 
+    if (qFuzzyCompare(scale.width(), 1.0) && qFuzzyCompare(scale.height(), 1.0))
+        painter->drawText(rect.bottomLeft(), text);
+    else {
         painter->save();
         painter->translate(rect.left(), rect.bottom());
-        painter->scale(invScaleX, invScaleY);
+        painter->scale(scale.width(), scale.height());
         painter->drawText(0, 0, text);
         painter->restore();
-    } else
-        painter->drawText(rect.bottomLeft(), text);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -470,7 +470,8 @@ private:
                         int posInDocument, const QTextFormat &format);
     void drawSceneIcon(QPainter *painter, const QRectF &rect, QTextDocument *doc, int posInDocument,
                        const QTextFormat &format);
-    void drawText(QPainter *painter, const QRectF &rect, const QString &text);
+    void drawText(QPainter *painter, const QRectF &rect, const QString &text,
+                  const QTextDocument *doc);
 };
 
 class SceneElementBlockTextUpdater : public QObject
@@ -244,8 +244,7 @@ void ScriteDocumentBackups::loadMetaData(int row)
                     return ret;
                 }
 
-                const QJsonDocument jsonDoc = QJsonDocument::fromJson(dfs.header());
-                const QJsonObject docObj = jsonDoc.object();
+                const QJsonObject docObj = DocumentFileSystem::decodeHeader(dfs.header());
 
                 const QJsonObject structure = docObj.value(QStringLiteral("structure")).toObject();
                 ret.structureElementCount =
@@ -743,6 +742,10 @@ ScriteDocument::ScriteDocument(QObject *parent)
     if (!mbc.isNull())
         m_maxBackupCount = mbc.toInt();
 
+    const QVariant bh = settings->value(QStringLiteral("Installation/binaryDocumentHeader"));
+    if (!bh.isNull())
+        m_binaryHeader = bh.toBool();
+
     connect(this, &ScriteDocument::collaboratorsChanged, this,
             &ScriteDocument::canModifyCollaboratorsChanged);
     connect(User::instance(), &User::loggedInChanged, this,
@@ -1116,6 +1119,18 @@ void ScriteDocument::setMaxBackupCount(int val)
     settings->setValue(QStringLiteral("Installation/maxBackupCount"), m_maxBackupCount);
 }
 
+void ScriteDocument::setBinaryHeader(bool val)
+{
+    if (m_binaryHeader == val)
+        return;
+
+    m_binaryHeader = val;
+    emit binaryHeaderChanged();
+
+    QSettings *settings = Application::instance()->settings();
+    settings->setValue(QStringLiteral("Installation/binaryDocumentHeader"), m_binaryHeader);
+}
+
 void ScriteDocument::reset()
 {
     HourGlass hourGlass;
@@ -1286,7 +1301,14 @@ bool ScriteDocument::openAnonymously(const QString &fileName)
 
     this->setBusyMessage("Loading ...");
     this->reset();
+
+    // Anonymous documents are mostly opened from temporary files, which are removed soon
+    // after. So everything is extracted right away, instead of upon first access.
+    const bool lazyLoad = m_docFileSystem.isLazyLoadEnabled();
+    m_docFileSystem.setLazyLoadEnabled(false);
     const bool ret = this->load(fileName);
+    m_docFileSystem.setLazyLoadEnabled(lazyLoad);
+
     this->setModified(false);
     this->clearBusyMessage();
 
@@ -1297,6 +1319,73 @@ bool ScriteDocument::openAnonymously(const QString &fileName)
     return ret;
 }
 
+/**
+ * Snapshot of the document, taken on the main thread for auto-save. Scene elements make up
+ * for most of the document, so they are captured as value snapshots, indexed by structure
+ * element. JSON of everything else is captured as is. The snapshot can be turned into
+ * document JSON on any thread.
+ */
+struct ScriteDocumentSnapshot
+{
+    QJsonObject json;
+    QVector<QVector<SceneElementSnapshot>> sceneElements;
+
+    static ScriteDocumentSnapshot take(ScriteDocument *document);
+    QJsonObject toJson() const;
+};
+
+ScriteDocumentSnapshot ScriteDocumentSnapshot::take(ScriteDocument *document)
+{
+    ScriteDocumentSnapshot ret;
+
+    Scene::setElementsSerializedSeparately(true);
+    ret.json = QObjectSerializer::toJson(document);
+    Scene::setElementsSerializedSeparately(false);
+
+    const Structure *structure = document->structure();
+    const int nrElements = structure->elementCount();
+    ret.sceneElements.reserve(nrElements);
+    for (int i = 0; i < nrElements; i++) {
+        const StructureElement *element = structure->elementAt(i);
+        const Scene *scene = element->scene();
+        ret.sceneElements.append(scene ? scene->elementSnapshots()
+                                       : QVector<SceneElementSnapshot>());
+    }
+
+    return ret;
+}
+
+QJsonObject ScriteDocumentSnapshot::toJson() const
+{
+    const QString structureKey = QStringLiteral("structure");
+    const QString elementsKey = QStringLiteral("elements");
+    const QString sceneKey = QStringLiteral("scene");
+
+    QJsonObject structure = json.value(structureKey).toObject();
+    const QJsonArray elements = structure.value(elementsKey).toArray();
+
+    QJsonArray newElements;
+    for (int i = 0; i < elements.size(); i++) {
+        QJsonObject element = elements.at(i).toObject();
+        if (i < sceneElements.size() && element.contains(sceneKey)) {
+            QJsonArray sceneElementsJson;
+            for (const SceneElementSnapshot &sceneElement : sceneElements.at(i))
+                sceneElementsJson.append(sceneElement.toJson());
+
+            QJsonObject scene = element.value(sceneKey).toObject();
+            scene.insert(elementsKey, sceneElementsJson);
+            element.insert(sceneKey, scene);
+        }
+        newElements.append(element);
+    }
+
+    structure.insert(elementsKey, newElements);
+
+    QJsonObject ret = json;
+    ret.insert(structureKey, structure);
+    return ret;
+}
+
 void ScriteDocument::saveAs(const QString &givenFileName)
 {
     HourGlass hourGlass;
@@ -1337,21 +1426,50 @@ void ScriteDocument::saveAs(const QString &givenFileName)
 
     emit aboutToSave();
 
-    const QJsonObject json = QObjectSerializer::toJson(this);
-    const QByteArray bytes = QJsonDocument(json).toJson();
-    m_docFileSystem.setHeader(bytes);
+    const DocumentFileSystem::HeaderFormat headerFormat = m_binaryHeader
+            ? DocumentFileSystem::BinaryHeaderFormat
+            : DocumentFileSystem::JsonHeaderFormat;
 
 #ifndef QT_NO_DEBUG_OUTPUT
     const bool saveJson = true;
 #else
     const bool saveJson = qgetenv("SCRITE_SAVE_JSON").toUpper() == QByteArrayLiteral("YES");
 #endif
+    QString jsonFileName;
     if (saveJson) {
         const QFileInfo fi(fileName);
-        const QString fileName2 = fi.absolutePath() + "/" + fi.completeBaseName() + ".json";
-        QFile file2(fileName2);
-        file2.open(QFile::WriteOnly);
-        file2.write(bytes);
+        jsonFileName = fi.absolutePath() + "/" + fi.completeBaseName() + ".json";
+    }
+
+    if (m_autoSaveMode) {
+        // Only a snapshot of the document is taken on the main thread. Encoding it
+        // into the header happens on the thread that saves the document, so that
+        // typing doesn't freeze while auto-save is underway.
+        const ScriteDocumentSnapshot snapshot = ScriteDocumentSnapshot::take(this);
+        m_docFileSystem.setHeaderFunction([snapshot, headerFormat, jsonFileName]() {
+            const QJsonObject json = snapshot.toJson();
+            const QByteArray bytes = DocumentFileSystem::encodeHeader(json, headerFormat);
+            if (!jsonFileName.isEmpty()) {
+                QFile file2(jsonFileName);
+                file2.open(QFile::WriteOnly);
+                file2.write(headerFormat == DocumentFileSystem::JsonHeaderFormat
+                                    ? bytes
+                                    : QJsonDocument(json).toJson());
+            }
+            return bytes;
+        });
+    } else {
+        const QJsonObject json = QObjectSerializer::toJson(this);
+        const QByteArray bytes = DocumentFileSystem::encodeHeader(json, headerFormat);
+        m_docFileSystem.setHeader(bytes);
+
+        if (!jsonFileName.isEmpty()) {
+            QFile file2(jsonFileName);
+            file2.open(QFile::WriteOnly);
+            file2.write(headerFormat == DocumentFileSystem::JsonHeaderFormat
+                                ? bytes
+                                : QJsonDocument(json).toJson());
+        }
     }
 
     if (m_autoSaveMode) {
@@ -2184,9 +2302,9 @@ bool ScriteDocument::load(const QString &fileName)
         return false;
     }
 
-    const QJsonDocument jsonDoc = format == DocumentFileSystem::ZipFormat
-            ? QJsonDocument::fromJson(m_docFileSystem.header())
-            : QJsonDocument::fromBinaryData(m_docFileSystem.header());
+    const QJsonObject json = format == DocumentFileSystem::ZipFormat
+            ? DocumentFileSystem::decodeHeader(m_docFileSystem.header())
+            : QJsonDocument::fromBinaryData(m_docFileSystem.header()).object();
 
 #ifndef QT_NO_DEBUG_OUTPUT
     {
@@ -2194,11 +2312,10 @@ bool ScriteDocument::load(const QString &fileName)
         const QString fileName2 = fi.absolutePath() + "/" + fi.completeBaseName() + ".json";
         QFile file2(fileName2);
         file2.open(QFile::WriteOnly);
-        file2.write(jsonDoc.toJson());
+        file2.write(QJsonDocument(json).toJson());
     }
 #endif
 
-    const QJsonObject json = jsonDoc.object();
     if (json.isEmpty()) {
         m_errorReport->setErrorMessage(QStringLiteral("%1 is not a Scrite document.").arg(fileName),
                                        details);
@@ -2266,7 +2383,22 @@ bool ScriteDocument::load(const QString &fileName)
     loadCleanup.begin();
 
     UndoStack::ignoreUndoCommands = true;
-    const bool ret = QObjectSerializer::fromJson(json, this);
+
+    // Elements of all scenes are prepared on a thread pool, while the rest of the
+    // document is constructed here. Scenes pick up their elements as they get constructed.
+    const QJsonArray structureElements = json.value(QStringLiteral("structure"))
+                                                 .toObject()
+                                                 .value(QStringLiteral("elements"))
+                                                 .toArray();
+    bool ret = false;
+    {
+        SceneElementsLoader sceneElementsLoader(structureElements);
+        m_progressReport->setProgressStepFromCount(qMax(1, sceneElementsLoader.sceneCount()));
+        sceneElementsLoader.setSceneLoadedCallback([=]() { m_progressReport->tick(); });
+
+        ret = QObjectSerializer::fromJson(json, this);
+    }
+
     if (m_screenplay->currentElementIndex() == 0)
         m_screenplay->setCurrentElementIndex(-1);
     UndoStack::ignoreUndoCommands = false;
@@ -490,6 +490,13 @@ public:
     int maxBackupCount() const { return m_maxBackupCount; }
     Q_SIGNAL void maxBackupCountChanged();
 
+    // When set, documents are saved with a compact binary header, which is faster
+    // to save and open. Such documents cannot be opened in older versions of Scrite.
+    Q_PROPERTY(bool binaryHeader READ isBinaryHeader WRITE setBinaryHeader NOTIFY binaryHeaderChanged)
+    void setBinaryHeader(bool val);
+    bool isBinaryHeader() const { return m_binaryHeader; }
+    Q_SIGNAL void binaryHeaderChanged();
+
     Q_INVOKABLE void reset();
 
     Q_INVOKABLE bool openOrImport(const QString &fileName);
@@ -600,6 +607,7 @@ private:
     bool m_readOnly = false;
     bool m_autoSaveMode = false;
     int m_maxBackupCount = 20;
+    bool m_binaryHeader = false;
     QString m_sessionId;
     bool m_fromScriptalay = false;
     QString m_documentId;
@@ -272,8 +272,7 @@ void ScriteDocumentVault::updateModelFromFolder()
 
                 DocumentFileSystem dfs;
                 if (dfs.load(fi.absoluteFilePath())) {
-                    const QJsonDocument jsonDoc = QJsonDocument::fromJson(dfs.header());
-                    const QJsonObject docObj = jsonDoc.object();
+                    const QJsonObject docObj = DocumentFileSystem::decodeHeader(dfs.header());
 
                     metaData.documentId = docObj.value(QStringLiteral("documentId")).toString();
 
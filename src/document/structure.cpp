@@ -2577,6 +2577,24 @@ Structure::Structure(QObject *parent)
     connect(clipboardTimer, &QTimer::timeout, clipboardTimer, &QTimer::deleteLater);
     clipboardTimer->start();
 
+    // Lookup indexes are rebuilt on demand, after any change to the lists they index.
+    connect(&m_characters, &QAbstractItemModel::rowsInserted, this,
+            &Structure::invalidateCharacterIndex);
+    connect(&m_characters, &QAbstractItemModel::rowsRemoved, this,
+            &Structure::invalidateCharacterIndex);
+    connect(&m_characters, &QAbstractItemModel::rowsMoved, this,
+            &Structure::invalidateCharacterIndex);
+    connect(&m_characters, &QAbstractItemModel::modelReset, this,
+            &Structure::invalidateCharacterIndex);
+    connect(&m_elements, &QAbstractItemModel::rowsInserted, this,
+            &Structure::invalidateElementIndexes);
+    connect(&m_elements, &QAbstractItemModel::rowsRemoved, this,
+            &Structure::invalidateElementIndexes);
+    connect(&m_elements, &QAbstractItemModel::rowsMoved, this,
+            &Structure::invalidateElementIndexes);
+    connect(&m_elements, &QAbstractItemModel::modelReset, this,
+            &Structure::invalidateElementIndexes);
+
     m_elementsBoundingBoxAggregator.setModel(&m_elements);
     m_elementsBoundingBoxAggregator.setAggregateFunction(
             [=](const QModelIndex &index, QVariant &value) {
@@ -2615,8 +2633,19 @@ Structure::Structure(QObject *parent)
 
     this->loadDefaultGroupsData();
 
-    m_transitions = defaultTransitions();
-    m_shots = defaultShots();
+    m_characterElementMap.setTrackChanges(true);
+    m_transitionElementMap.setTrackChanges(true);
+    m_shotElementMap.setTrackChanges(true);
+
+    const QStringList transitions = defaultTransitions();
+    for (const QString &transition : transitions)
+        m_transitionRefs[transition]++;
+    m_transitions = m_transitionRefs.keys();
+
+    const QStringList shots = defaultShots();
+    for (const QString &shot : shots)
+        m_shotRefs[shot]++;
+    m_shots = m_shotRefs.keys();
 }
 
 Structure::~Structure()
@@ -2716,11 +2745,15 @@ void Structure::addCharacter(Character *ptr)
 
     connect(ptr, &Character::aboutToDelete, this, &Structure::removeCharacter);
     connect(ptr, &Character::characterChanged, this, &Structure::structureChanged);
+    connect(ptr, &Character::nameChanged, this, &Structure::invalidateCharacterIndex);
+    connect(ptr, &Character::nameChanged, this, &Structure::onCharactersChanged);
+    connect(ptr, &Character::tagsChanged, this, &Structure::onCharactersChanged);
+    connect(ptr, &Character::priorityChanged, this, &Structure::onCharactersChanged);
 
     m_characters.append(ptr);
     emit characterCountChanged();
 
-    this->updateCharacterNamesShotsTransitionsAndTagsLater();
+    this->onCharactersChanged();
 }
 
 void Structure::removeCharacter(Character *ptr)
@@ -2736,10 +2769,14 @@ void Structure::removeCharacter(Character *ptr)
 
     disconnect(ptr, &Character::aboutToDelete, this, &Structure::removeCharacter);
     disconnect(ptr, &Character::characterChanged, this, &Structure::structureChanged);
+    disconnect(ptr, &Character::nameChanged, this, &Structure::invalidateCharacterIndex);
+    disconnect(ptr, &Character::nameChanged, this, &Structure::onCharactersChanged);
+    disconnect(ptr, &Character::tagsChanged, this, &Structure::onCharactersChanged);
+    disconnect(ptr, &Character::priorityChanged, this, &Structure::onCharactersChanged);
 
     emit characterCountChanged();
 
-    this->updateCharacterNamesShotsTransitionsAndTagsLater();
+    this->onCharactersChanged();
 
     if (ptr->parent() == this)
         GarbageCollector::instance()->add(ptr);
@@ -2776,13 +2813,17 @@ void Structure::setCharacters(const QList<Character *> &list)
         ptr->setParent(this);
         connect(ptr, &Character::aboutToDelete, this, &Structure::removeCharacter);
         connect(ptr, &Character::characterChanged, this, &Structure::structureChanged);
+        connect(ptr, &Character::nameChanged, this, &Structure::invalidateCharacterIndex);
+        connect(ptr, &Character::nameChanged, this, &Structure::onCharactersChanged);
+        connect(ptr, &Character::tagsChanged, this, &Structure::onCharactersChanged);
+        connect(ptr, &Character::priorityChanged, this, &Structure::onCharactersChanged);
         list2.append(ptr);
     }
 
     m_characters.assign(list2);
     emit characterCountChanged();
 
-    this->updateCharacterNamesShotsTransitionsAndTagsLater();
+    this->onCharactersChanged();
 }
 
 void Structure::clearCharacters()
@@ -2833,13 +2874,16 @@ void Structure::addCharacters(const QStringList &names)
 
 Character *Structure::findCharacter(const QString &name) const
 {
-    const QString name2 = name.trimmed().toUpper();
-    for (Character *character : m_characters.constList()) {
-        if (character->name() == name2)
-            return character;
-    }
+    this->updateCharacterIndex();
 
-    return nullptr;
+    // Names passed to us are mostly in the same form as we store them.
+    Character *ret = m_characterIndex.value(name);
+    if (ret == nullptr)
+        ret = m_characterIndex.value(name.trimmed().toUpper());
+
+    Q_ASSERT_X(ret == nullptr || ret->name() == name || ret->name() == name.trimmed().toUpper(),
+               "Structure", "Character index is out of sync");
+    return ret;
 }
 
 QList<Character *> Structure::findCharacters(const QStringList &names,
@@ -2912,6 +2956,7 @@ void Structure::removeElement(StructureElement *ptr)
     const QList<SceneElement *> sceneElements = scene->findChildren<SceneElement *>();
     for (SceneElement *sceneElement : sceneElements)
         this->onAboutToRemoveSceneElement(sceneElement);
+    m_characterIncidence.remove(scene);
     this->updateCharacterNamesShotsTransitionsAndTagsLater();
 
     m_elements.removeAt(index);
@@ -2926,6 +2971,7 @@ void Structure::removeElement(StructureElement *ptr)
                &QObjectListModel<StructureElement *>::objectDestroyed);
     disconnect(ptr, &StructureElement::stackIdChanged, &m_elementStacks,
                &StructureElementStacks::evaluateStacksLater);
+    disconnect(ptr, &StructureElement::sceneChanged, this, &Structure::invalidateElementIndexes);
     this->updateLocationHeadingMapLater();
 
     emit elementCountChanged();
@@ -2984,6 +3030,7 @@ void Structure::insertElement(StructureElement *ptr, int index)
             &QObjectListModel<StructureElement *>::objectDestroyed);
     connect(ptr, &StructureElement::stackIdChanged, &m_elementStacks,
             &StructureElementStacks::evaluateStacksLater);
+    connect(ptr, &StructureElement::sceneChanged, this, &Structure::invalidateElementIndexes);
     this->updateLocationHeadingMapLater();
 
     this->onStructureElementSceneChanged(ptr);
@@ -3035,6 +3082,8 @@ void Structure::setElements(const QList<StructureElement *> &list)
                 &QObjectListModel<StructureElement *>::objectDestroyed);
         connect(element, &StructureElement::stackIdChanged, &m_elementStacks,
                 &StructureElementStacks::evaluateStacksLater);
+        connect(element, &StructureElement::sceneChanged, this,
+                &Structure::invalidateElementIndexes);
         this->onStructureElementSceneChanged(element);
     }
 
@@ -3062,17 +3111,23 @@ int Structure::indexOfScene(Scene *scene) const
     if (scene == nullptr)
         return -1;
 
-    for (int i = 0; i < m_elements.size(); i++) {
-        StructureElement *element = m_elements.at(i);
-        if (element->scene() == scene)
-            return i;
-    }
+    this->updateElementIndexes();
 
-    return -1;
+    const int ret = m_sceneIndex.value(scene, -1);
+    Q_ASSERT_X(ret < 0 || (ret < m_elements.size() && m_elements.at(ret)->scene() == scene),
+               "Structure", "Scene index is out of sync");
+    return ret;
 }
 
 int Structure::indexOfElement(StructureElement *element) const
 {
+    if (element == nullptr || element->scene() == nullptr)
+        return m_elements.indexOf(element);
+
+    const int index = this->indexOfScene(element->scene());
+    if (index >= 0 && m_elements.at(index) == element)
+        return index;
+
     return m_elements.indexOf(element);
 }
 
@@ -3081,12 +3136,90 @@ StructureElement *Structure::findElementBySceneID(const QString &id) const
     if (id.isEmpty())
         return nullptr;
 
-    for (StructureElement *element : m_elements.constList()) {
-        if (element->scene()->id() == id)
-            return element;
+    this->updateElementIndexes();
+
+    StructureElement *ret = m_sceneIdElementIndex.value(id);
+    Q_ASSERT_X(ret == nullptr || (ret->scene() != nullptr && ret->scene()->id() == id),
+               "Structure", "Scene ID index is out of sync");
+    return ret;
+}
+
+void Structure::updateCharacterIndex() const
+{
+    if (m_characterIndexIsValid)
+        return;
+
+    // If more than one character has the same name, the first one wins, just like it
+    // would with a linear search.
+    m_characterIndex.clear();
+    m_characterIndex.reserve(m_characters.size());
+    for (Character *character : m_characters.constList()) {
+        if (!m_characterIndex.contains(character->name()))
+            m_characterIndex.insert(character->name(), character);
     }
 
-    return nullptr;
+    m_characterIndexIsValid = true;
+    this->checkLookupIndexes();
+}
+
+void Structure::updateElementIndexes() const
+{
+    if (m_elementIndexesAreValid)
+        return;
+
+    m_sceneIndex.clear();
+    m_sceneIdElementIndex.clear();
+    m_sceneIndex.reserve(m_elements.size());
+    m_sceneIdElementIndex.reserve(m_elements.size());
+    for (int i = 0; i < m_elements.size(); i++) {
+        StructureElement *element = m_elements.at(i);
+        const Scene *scene = element->scene();
+        if (scene == nullptr)
+            continue;
+
+        if (!m_sceneIndex.contains(scene))
+            m_sceneIndex.insert(scene, i);
+        if (!m_sceneIdElementIndex.contains(scene->id()))
+            m_sceneIdElementIndex.insert(scene->id(), element);
+    }
+
+    m_elementIndexesAreValid = true;
+    this->checkLookupIndexes();
+}
+
+void Structure::checkLookupIndexes() const
+{
+#ifndef QT_NO_DEBUG
+    // Lookup indexes must give the same answers as searching through the lists would.
+    if (m_characterIndexIsValid) {
+        for (Character *character : m_characters.constList()) {
+            const Character *indexed = m_characterIndex.value(character->name());
+            Q_ASSERT_X(indexed != nullptr && indexed->name() == character->name(), "Structure",
+                       "Character index is out of sync");
+        }
+        Q_ASSERT_X(m_characterIndex.size() <= m_characters.size(), "Structure",
+                   "Character index has stale entries");
+    }
+
+    if (m_elementIndexesAreValid) {
+        for (int i = 0; i < m_elements.size(); i++) {
+            const Scene *scene = m_elements.at(i)->scene();
+            if (scene == nullptr)
+                continue;
+
+            const int index = m_sceneIndex.value(scene, -1);
+            Q_ASSERT_X(index >= 0 && index <= i && m_elements.at(index)->scene() == scene,
+                       "Structure", "Scene index is out of sync");
+
+            const StructureElement *indexed = m_sceneIdElementIndex.value(scene->id());
+            Q_ASSERT_X(indexed != nullptr && indexed->scene()->id() == scene->id(), "Structure",
+                       "Scene ID index is out of sync");
+        }
+        Q_ASSERT_X(m_sceneIndex.size() <= m_elements.size()
+                           && m_sceneIdElementIndex.size() <= m_elements.size(),
+                   "Structure", "Scene indexes have stale entries");
+    }
+#endif
 }
 
 QRectF Structure::layoutElements(Structure::LayoutType layoutType)
@@ -3120,9 +3253,15 @@ QRectF Structure::layoutElements(Structure::LayoutType layoutType)
             stackIds.append(element->stackId());
     }
 
-    auto lessThan = [screenplay](StructureElement *e1, StructureElement *e2) -> bool {
-        const int pos1 = screenplay->firstIndexOfScene(e1->scene());
-        const int pos2 = screenplay->firstIndexOfScene(e2->scene());
+    // Look up screenplay positions once, rather than twice for every comparison.
+    QHash<StructureElement *, int> positions;
+    positions.reserve(elementsToLayout.size());
+    for (StructureElement *element : qAsConst(elementsToLayout))
+        positions.insert(element, screenplay->firstIndexOfScene(element->scene()));
+
+    auto lessThan = [&positions](StructureElement *e1, StructureElement *e2) -> bool {
+        const int pos1 = positions.value(e1, -1);
+        const int pos2 = positions.value(e2, -1);
         if (pos1 >= 0 && pos2 >= 0)
             return pos1 < pos2;
         if (pos2 < 0)
@@ -4659,6 +4798,39 @@ void Structure::setPropertyFromObjectList(const QString &propName, const QList<Q
     }
 }
 
+SceneCharacterIncidence Structure::characterIncidence(const Scene *scene) const
+{
+    SceneCharacterIncidence ret;
+    if (scene == nullptr)
+        return ret;
+
+    auto it = m_characterIncidence.constFind(scene);
+    if (it != m_characterIncidence.constEnd())
+        return it.value();
+
+    // Each character paragraph starts a dialogue, except those added for mute characters.
+    const CharacterElementMap &characterElementMap = scene->characterElementMap();
+    const QStringList names = characterElementMap.characterNames();
+    for (const QString &name : names) {
+        int nrDialogues = 0;
+        const QList<SceneElement *> elements = characterElementMap.characterElements(name);
+        for (const SceneElement *element : elements) {
+            const QVariant mute = element->property("#mute");
+            if (!mute.isValid() || !mute.toBool())
+                ++nrDialogues;
+        }
+
+        ret.dialogueCounts.insert(name, nrDialogues);
+    }
+
+    // Only scenes in this structure report changes to us, others can't be cached.
+    this->updateElementIndexes();
+    if (m_sceneIndex.contains(scene))
+        m_characterIncidence.insert(scene, ret);
+
+    return ret;
+}
+
 QStringList Structure::sortCharacterNames(const QStringList &givenNames) const
 {
     if (givenNames.length() <= 1)
@@ -4906,11 +5078,12 @@ void Structure::onStructureElementSceneChanged(StructureElement *element)
             &Structure::onAboutToRemoveSceneElement);
 
     Scene *scene = element->scene();
+    m_characterIncidence.remove(scene);
     for (int i = 0; i < scene->elementCount(); i++) {
         SceneElement *element = scene->elementAt(i);
-        if (!m_characterElementMap.include(element))
-            if (!m_transitionElementMap.include(element))
-                m_shotElementMap.include(element);
+        m_characterElementMap.include(element);
+        m_transitionElementMap.include(element);
+        m_shotElementMap.include(element);
     }
 
     this->updateLocationHeadingMapLater();
@@ -4919,66 +5092,103 @@ void Structure::onStructureElementSceneChanged(StructureElement *element)
 
 void Structure::onSceneElementChanged(SceneElement *element, Scene::SceneElementChangeType)
 {
-    if (m_characterElementMap.include(element) || m_transitionElementMap.include(element)
-        || m_shotElementMap.include(element))
+    m_characterIncidence.remove(element->scene());
+
+    // An element may have moved from one map to another, so all of them must see it.
+    const bool c = m_characterElementMap.include(element);
+    const bool t = m_transitionElementMap.include(element);
+    const bool s = m_shotElementMap.include(element);
+    if (c || t || s)
         updateCharacterNamesShotsTransitionsAndTagsLater();
 }
 
 void Structure::onAboutToRemoveSceneElement(SceneElement *element)
 {
-    if (m_characterElementMap.remove(element) || m_transitionElementMap.remove(element)
-        || m_shotElementMap.remove(element))
+    m_characterIncidence.remove(element->scene());
+
+    const bool c = m_characterElementMap.remove(element);
+    const bool t = m_transitionElementMap.remove(element);
+    const bool s = m_shotElementMap.remove(element);
+    if (c || t || s)
         updateCharacterNamesShotsTransitionsAndTagsLater();
 }
 
-void Structure::updateCharacterNamesShotsTransitionsAndTags()
+template <class RefCounts>
+static bool ApplyValueChanges(RefCounts &refs, const QSet<QString> &addedValues,
+                              const QSet<QString> &removedValues)
 {
-    QStringList names = m_characterElementMap.characterNames();
-    QSet<QString> tags;
+    // Returns true if a value gained its first reference, or lost its last one.
+    bool ret = false;
 
-    const QList<Character *> characters = m_characters.list();
-    for (Character *character : characters) {
-        const QString name = character->name();
-        if (!names.contains(name))
-            names.append(name);
+    for (const QString &value : removedValues) {
+        auto it = refs.find(value);
+        if (it == refs.end())
+            continue;
 
-        const QStringList ctags = character->tags();
-        tags += QSet<QString>(ctags.begin(), ctags.end());
+        if (--it.value() <= 0) {
+            refs.erase(it);
+            ret = true;
+        }
     }
 
-    names = this->sortCharacterNames(names);
-    if (names != m_characterNames) {
-        m_characterNames = names;
-        emit characterNamesChanged();
+    for (const QString &value : addedValues) {
+        if (refs[value]++ == 0)
+            ret = true;
     }
 
-    const QStringList tagValues = tags.values();
-    if (tagValues != m_characterTags) {
-        m_characterTags = tags.values();
-        emit characterTagsChanged();
+    return ret;
+}
+
+void Structure::updateCharacterNamesShotsTransitionsAndTags()
+{
+    QSet<QString> addedValues, removedValues;
+
+    // Characters whose names, tags or priorities changed, need the list to be sorted again.
+    bool resortNames = m_charactersChanged;
+    if (m_characterElementMap.takeChanges(&addedValues, &removedValues))
+        resortNames |= ::ApplyValueChanges(m_characterNameRefs, addedValues, removedValues);
+
+    if (m_charactersChanged) {
+        QSet<QString> names;
+        QSet<QString> tags;
+
+        for (Character *character : m_characters.constList()) {
+            names.insert(character->name());
+
+            const QStringList ctags = character->tags();
+            for (const QString &ctag : ctags)
+                tags.insert(ctag);
+        }
+
+        ::ApplyValueChanges(m_characterNameRefs, names - m_characterObjectNames,
+                            m_characterObjectNames - names);
+        m_characterObjectNames = names;
+        m_charactersChanged = false;
+
+        const QStringList tagValues = tags.values();
+        if (tagValues != m_characterTags) {
+            m_characterTags = tagValues;
+            emit characterTagsChanged();
+        }
     }
 
-    const QStringList shots = [=]() {
-        QSet<QString> set = QSet<QString>::fromList(m_shotElementMap.shots());
-        set += QSet<QString>::fromList(defaultShots());
-        QStringList ret = QStringList::fromSet(set);
-        std::sort(ret.begin(), ret.end());
-        return ret;
-    }();
-    if (shots != m_shots) {
-        m_shots = shots;
+    if (resortNames) {
+        const QStringList names = this->sortCharacterNames(m_characterNameRefs.keys());
+        if (names != m_characterNames) {
+            m_characterNames = names;
+            emit characterNamesChanged();
+        }
+    }
+
+    if (m_shotElementMap.takeChanges(&addedValues, &removedValues)
+        && ::ApplyValueChanges(m_shotRefs, addedValues, removedValues)) {
+        m_shots = m_shotRefs.keys();
         emit shotsChanged();
     }
 
-    const QStringList transitions = [=]() {
-        QSet<QString> set = QSet<QString>::fromList(m_transitionElementMap.transitions());
-        set += QSet<QString>::fromList(defaultTransitions());
-        QStringList ret = QStringList::fromSet(set);
-        std::sort(ret.begin(), ret.end());
-        return ret;
-    }();
-    if (transitions != m_transitions) {
-        m_transitions = transitions;
+    if (m_transitionElementMap.takeChanges(&addedValues, &removedValues)
+        && ::ApplyValueChanges(m_transitionRefs, addedValues, removedValues)) {
+        m_transitions = m_transitionRefs.keys();
         emit transitionsChanged();
     }
 }
@@ -4988,6 +5198,12 @@ void Structure::updateCharacterNamesShotsTransitionsAndTagsLater()
     m_updateCharacterNamesShotsTransitionsAndTagsTimer.start(0, this);
 }
 
+void Structure::onCharactersChanged()
+{
+    m_charactersChanged = true;
+    this->updateCharacterNamesShotsTransitionsAndTagsLater();
+}
+
 void Structure::staticAppendAnnotation(QQmlListProperty<Annotation> *list, Annotation *ptr)
 {
     reinterpret_cast<Structure *>(list->data)->addAnnotation(ptr);
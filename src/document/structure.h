@@ -750,6 +750,19 @@ private:
     QJsonObject m_attributes;
 };
 
+/**
+ * Characters present in a scene, with the number of dialogues each of them speaks in it.
+ * Mute characters are present, with no dialogues.
+ */
+struct SceneCharacterIncidence
+{
+    QHash<QString, int> dialogueCounts;
+
+    bool isEmpty() const { return dialogueCounts.isEmpty(); }
+    bool contains(const QString &name) const { return dialogueCounts.contains(name); }
+    int dialogueCount(const QString &name) const { return dialogueCounts.value(name, 0); }
+};
+
 class Structure : public QObject, public QObjectSerializer::Interface
 {
     Q_OBJECT
@@ -917,6 +930,10 @@ public:
     QStringList characterNames() const { return m_characterNames; }
     Q_SIGNAL void characterNamesChanged();
 
+    // Reports look this up for every scene and character they cover, so it is cached per
+    // scene until one of its paragraphs changes.
+    SceneCharacterIncidence characterIncidence(const Scene *scene) const;
+
     Q_PROPERTY(QStringList transitions READ transitions NOTIFY transitionsChanged)
     QStringList transitions() const { return m_transitions; }
     Q_SIGNAL void transitionsChanged();
@@ -1072,6 +1089,20 @@ private:
     static int staticElementCount(QQmlListProperty<StructureElement> *list);
     QObjectListModel<StructureElement *> m_elements;
     ModelAggregator m_elementsBoundingBoxAggregator;
+
+    // Lookup indexes for findCharacter(), findElementBySceneID() and indexOfScene().
+    // They are rebuilt on first use after m_characters or m_elements change. Debug builds
+    // check indexes in full only when they are rebuilt, lookups only check what they return.
+    void invalidateCharacterIndex() { m_characterIndexIsValid = false; }
+    void invalidateElementIndexes() { m_elementIndexesAreValid = false; }
+    void updateCharacterIndex() const;
+    void updateElementIndexes() const;
+    void checkLookupIndexes() const;
+    mutable bool m_characterIndexIsValid = false;
+    mutable QHash<QString, Character *> m_characterIndex;
+    mutable bool m_elementIndexesAreValid = false;
+    mutable QHash<QString, StructureElement *> m_sceneIdElementIndex;
+    mutable QHash<const Scene *, int> m_sceneIndex;
     StructureElementStacks m_elementStacks;
     int m_currentElementIndex = -1;
     qreal m_zoomLevel = 1.0;
@@ -1086,6 +1117,7 @@ private:
     void onAboutToRemoveSceneElement(SceneElement *element);
     void updateCharacterNamesShotsTransitionsAndTags();
     void updateCharacterNamesShotsTransitionsAndTagsLater();
+    void onCharactersChanged();
     ExecLaterTimer m_updateCharacterNamesShotsTransitionsAndTagsTimer;
     CharacterElementMap m_characterElementMap;
     TransitionElementMap m_transitionElementMap;
@@ -1095,6 +1127,17 @@ private:
     QStringList m_shots;
     QStringList m_transitions;
 
+    // Reference counts of values listed in m_characterNames, m_shots and m_transitions.
+    // Each distinct value in an element map holds one reference, and so does each Character
+    // for its name and each default shot or transition. Lists are evaluated again only when
+    // a value gains its first reference or loses its last one.
+    QHash<QString, int> m_characterNameRefs;
+    QMap<QString, int> m_shotRefs;
+    QMap<QString, int> m_transitionRefs;
+    QSet<QString> m_characterObjectNames;
+    bool m_charactersChanged = false;
+    mutable QHash<const Scene *, SceneCharacterIncidence> m_characterIncidence;
+
     static void staticAppendAnnotation(QQmlListProperty<Annotation> *list, Annotation *ptr);
     static void staticClearAnnotations(QQmlListProperty<Annotation> *list);
     static Annotation *staticAnnotationAt(QQmlListProperty<Annotation> *list, int index);
@@ -14,18 +14,120 @@
 #include "undoredo.h"
 #include "application.h"
 
+#include <QDir>
+#include <QSettings>
+#include <QJsonObject>
+#include <QTemporaryFile>
 #include <QQmlListReference>
 
-UndoStack::UndoStack(QObject *parent) : QUndoStack(parent)
+/**
+ * Append-only temporary file into which compressed state of undo commands is spilled.
+ * Space taken by state that was read back is not reclaimed. The file is deleted once
+ * the stack and all commands spilled into it let go of it.
+ */
+class UndoSpillFile
+{
+public:
+    UndoSpillFile()
+        : m_file(QDir::tempPath() + QStringLiteral("/scrite-undo-XXXXXX.bin"))
+    {
+        m_file.open();
+    }
+    ~UndoSpillFile() { }
+
+    qint64 size() const { return m_file.size(); }
+
+    qint64 append(const QByteArray &bytes)
+    {
+        if (!m_file.isOpen() || !m_file.seek(m_file.size()))
+            return -1;
+
+        const qint64 offset = m_file.pos();
+        if (m_file.write(bytes) != bytes.size())
+            return -1;
+
+        return offset;
+    }
+
+    QByteArray read(qint64 offset, qint64 size)
+    {
+        if (!m_file.isOpen() || !m_file.seek(offset))
+            return QByteArray();
+
+        const QByteArray ret = m_file.read(size);
+        return ret.size() == size ? ret : QByteArray();
+    }
+
+private:
+    QTemporaryFile m_file;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+UndoStack::UndoStack(QObject *parent)
+    : QUndoStack(parent), m_memoryBudgetTimer("UndoStack.m_memoryBudgetTimer")
 {
     Application::instance()->undoGroup()->addStack(this);
 
+    const qint64 budgetInMB =
+            Application::instance()->settings()->value("Undo/memoryBudgetInMB", 32).toLongLong();
+    m_memoryBudget = qMax(budgetInMB, qint64(1)) * 1024 * 1024;
+
     connect(Application::instance()->undoGroup(), &QUndoGroup::activeStackChanged, this,
             &UndoStack::activeChanged);
+
+    // Compressing and spilling commands takes a while, so it is done once the user pauses.
+    connect(this, &QUndoStack::indexChanged, this,
+            [=]() { m_memoryBudgetTimer.start(2000, this); });
 }
 
 UndoStack::~UndoStack() { }
 
+void UndoStack::setMemoryBudget(qint64 val)
+{
+    val = qMax(val, qint64(0));
+    if (m_memoryBudget == val)
+        return;
+
+    m_memoryBudget = val;
+    emit memoryBudgetChanged();
+
+    m_memoryBudgetTimer.start(0, this);
+}
+
+QJsonObject UndoStack::memoryStatistics() const
+{
+    int nrCommands[3] = { 0, 0, 0 };
+    qint64 nrBytes[3] = { 0, 0, 0 };
+    int nrOtherCommands = 0;
+
+    for (int i = 0; i < this->count(); i++) {
+        const CompactUndoCommand *cmd = dynamic_cast<const CompactUndoCommand *>(this->command(i));
+        if (cmd == nullptr) {
+            ++nrOtherCommands;
+            continue;
+        }
+
+        ++nrCommands[cmd->storage()];
+        nrBytes[cmd->storage()] += cmd->storage() == CompactUndoCommand::SpilledToDisk
+                ? cmd->m_spillSize
+                : cmd->memoryUsage();
+    }
+
+    QJsonObject ret;
+    ret.insert(QStringLiteral("budget"), m_memoryBudget);
+    ret.insert(QStringLiteral("commands"), this->count());
+    ret.insert(QStringLiteral("otherCommands"), nrOtherCommands);
+    ret.insert(QStringLiteral("inMemoryCommands"), nrCommands[CompactUndoCommand::InMemory]);
+    ret.insert(QStringLiteral("inMemoryBytes"), nrBytes[CompactUndoCommand::InMemory]);
+    ret.insert(QStringLiteral("compressedCommands"), nrCommands[CompactUndoCommand::Compressed]);
+    ret.insert(QStringLiteral("compressedBytes"), nrBytes[CompactUndoCommand::Compressed]);
+    ret.insert(QStringLiteral("spilledCommands"), nrCommands[CompactUndoCommand::SpilledToDisk]);
+    ret.insert(QStringLiteral("spilledBytes"), nrBytes[CompactUndoCommand::SpilledToDisk]);
+    ret.insert(QStringLiteral("spillFileSize"), m_spillFile.isNull() ? 0 : m_spillFile->size());
+    return ret;
+}
+
 void UndoStack::setActive(bool val)
 {
     if (val)
@@ -57,6 +159,141 @@ QUndoStack *UndoStack::active()
     return ret;
 }
 
+void UndoStack::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_memoryBudgetTimer.timerId()) {
+        m_memoryBudgetTimer.stop();
+        this->enforceMemoryBudget();
+    } else
+        QUndoStack::timerEvent(event);
+}
+
+void UndoStack::enforceMemoryBudget()
+{
+    // Commands this close to the current index are what users undo and redo most of the
+    // time, and the top command may yet merge with the next one. They are never compacted.
+    const int nrLiveCommands = 10;
+
+    // Commands are visited nearest to the current index first. They are kept as they are
+    // while total bytes in memory stays within half the budget, and compressed while it
+    // stays within the budget. All others are spilled into the spill file.
+    const int index = this->index();
+    QList<CompactUndoCommand *> commands;
+    for (int distance = 0; commands.size() < this->count(); distance++) {
+        for (int i : { index - 1 - distance, index + distance }) {
+            if (i >= 0 && i < this->count())
+                commands.append(dynamic_cast<CompactUndoCommand *>(
+                        const_cast<QUndoCommand *>(this->command(i))));
+        }
+    }
+
+    qint64 bytesInMemory = 0;
+    int nrSpilledCommands = 0;
+    for (int i = 0; i < commands.size(); i++) {
+        CompactUndoCommand *cmd = commands.at(i);
+        if (cmd == nullptr)
+            continue;
+
+        if (i >= nrLiveCommands) {
+            if (cmd->storage() == CompactUndoCommand::InMemory
+                && bytesInMemory + cmd->memoryUsage() > m_memoryBudget / 2)
+                cmd->compress();
+
+            if (cmd->storage() == CompactUndoCommand::Compressed
+                && bytesInMemory + cmd->memoryUsage() > m_memoryBudget) {
+                if (m_spillFile.isNull())
+                    m_spillFile.reset(new UndoSpillFile);
+                cmd->spill(m_spillFile);
+            }
+        }
+
+        if (cmd->storage() == CompactUndoCommand::SpilledToDisk)
+            ++nrSpilledCommands;
+        else
+            bytesInMemory += cmd->memoryUsage();
+    }
+
+    // Nothing refers to the spill file anymore, start over with an empty one next time.
+    if (nrSpilledCommands == 0)
+        m_spillFile.reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+CompactUndoCommand::CompactUndoCommand(QUndoCommand *parent) : QUndoCommand(parent) { }
+
+CompactUndoCommand::~CompactUndoCommand() { }
+
+qint64 CompactUndoCommand::memoryUsage() const
+{
+    switch (m_storage) {
+    case InMemory:
+        return this->stateSize();
+    case Compressed:
+        return m_compressedState.size();
+    case SpilledToDisk:
+        break;
+    }
+
+    return 0;
+}
+
+bool CompactUndoCommand::restoreState()
+{
+    if (m_storage == InMemory)
+        return true;
+
+    const QByteArray compressedState = m_storage == Compressed
+            ? m_compressedState
+            : m_spillFile->read(m_spillOffset, m_spillSize);
+    const QByteArray state = qUncompress(compressedState);
+
+    m_storage = InMemory;
+    m_compressedState.clear();
+    m_spillFile.reset();
+    m_spillOffset = -1;
+    m_spillSize = 0;
+
+    if (state.isEmpty() || !this->loadState(state)) {
+        this->releaseState();
+        this->setObsolete(true);
+        return false;
+    }
+
+    return true;
+}
+
+bool CompactUndoCommand::compress()
+{
+    if (m_storage != InMemory)
+        return false;
+
+    m_compressedState = qCompress(this->saveState());
+    if (m_compressedState.isEmpty())
+        return false;
+
+    this->releaseState();
+    m_storage = Compressed;
+    return true;
+}
+
+bool CompactUndoCommand::spill(const QSharedPointer<UndoSpillFile> &file)
+{
+    if (m_storage != Compressed || file.isNull())
+        return false;
+
+    const qint64 offset = file->append(m_compressedState);
+    if (offset < 0)
+        return false;
+
+    m_spillFile = file;
+    m_spillOffset = offset;
+    m_spillSize = m_compressedState.size();
+    m_compressedState.clear();
+    m_storage = SpilledToDisk;
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 int ObjectPropertyInfo::counter = 1000;
@@ -17,15 +17,21 @@
 #include <QtDebug>
 #include <QVariant>
 #include <QPointer>
+#include <QCborMap>
 #include <QUndoStack>
+#include <QCborValue>
 #include <QJsonObject>
 #include <QQmlProperty>
 #include <QQmlEngine>
+#include <QSharedPointer>
 
+#include "execlatertimer.h"
 #include "qobjectfactory.h"
 #include "garbagecollector.h"
 #include "qobjectserializer.h"
 
+class UndoSpillFile;
+
 class UndoStack : public QUndoStack
 {
     Q_OBJECT
@@ -40,10 +46,77 @@ public:
     bool isActive() const;
     Q_SIGNAL void activeChanged();
 
+    // Bytes of memory that undo history of this stack may take, roughly. See
+    // CompactUndoCommand for how history is kept within it.
+    Q_PROPERTY(
+            qint64 memoryBudget READ memoryBudget WRITE setMemoryBudget NOTIFY memoryBudgetChanged)
+    void setMemoryBudget(qint64 val);
+    qint64 memoryBudget() const { return m_memoryBudget; }
+    Q_SIGNAL void memoryBudgetChanged();
+
+    // Number of commands and bytes they take in memory, compressed and in the spill file.
+    Q_INVOKABLE QJsonObject memoryStatistics() const;
+
     static void clearAllStacks();
 
     static bool ignoreUndoCommands;
     static QUndoStack *active();
+
+protected:
+    void timerEvent(QTimerEvent *event);
+
+private:
+    void enforceMemoryBudget();
+
+private:
+    qint64 m_memoryBudget = 0;
+    ExecLaterTimer m_memoryBudgetTimer;
+    QSharedPointer<UndoSpillFile> m_spillFile;
+};
+
+/**
+ * Base class of undo commands that hold on to sizeable state, like snapshots of paragraphs
+ * or JSON of objects. UndoStack keeps commands closest to its current index as they are, and
+ * as history grows beyond its memory budget, compresses state of commands farther away.
+ * Compressed state of commands farthest away is moved into a temporary spill file.
+ *
+ * Subclasses must call restoreState() at the start of undo(), redo() and mergeWith(), and
+ * do nothing if it returns false.
+ */
+class CompactUndoCommand : public QUndoCommand
+{
+public:
+    explicit CompactUndoCommand(QUndoCommand *parent = nullptr);
+    ~CompactUndoCommand();
+
+    enum Storage { InMemory, Compressed, SpilledToDisk };
+    Storage storage() const { return m_storage; }
+
+    // Bytes taken by state of this command in memory, roughly.
+    qint64 memoryUsage() const;
+
+protected:
+    // Brings back state released by compress(). Returns false if it could not be read back,
+    // in which case the command is marked obsolete.
+    bool restoreState();
+
+    // Size of the state as it is in memory, approximately. Must be quick to evaluate.
+    virtual qint64 stateSize() const = 0;
+    virtual QByteArray saveState() const = 0;
+    virtual bool loadState(const QByteArray &bytes) = 0;
+    virtual void releaseState() = 0;
+
+private:
+    friend class UndoStack;
+    bool compress();
+    bool spill(const QSharedPointer<UndoSpillFile> &file);
+
+private:
+    Storage m_storage = InMemory;
+    QByteArray m_compressedState;
+    qint64 m_spillOffset = -1;
+    qint64 m_spillSize = 0;
+    QSharedPointer<UndoSpillFile> m_spillFile;
 };
 
 class ObjectPropertyInfoList;
@@ -184,7 +257,7 @@ enum Operation { InsertOperation, RemoveOperation };
 }
 
 template<class ParentClass, class ChildClass>
-class ObjectListCommand : public QUndoCommand
+class ObjectListCommand : public CompactUndoCommand
 {
     friend class PushObjectListCommand<ParentClass, ChildClass>;
 
@@ -217,7 +290,7 @@ class ObjectListCommand : public QUndoCommand
                     });
                     if (m_methods.indexOfMethod != nullptr)
                         m_childIndex = (*m_methods.indexOfMethod)(m_parent, m_child);
-                    m_childInfo = QObjectSerializer::toJson(m_child);
+                    this->setChildInfo(QObjectSerializer::toJson(m_child));
                 }
             }
         }
@@ -237,6 +310,9 @@ public:
     // QUndoCommand interface
     void undo()
     {
+        if (!this->restoreState())
+            return;
+
         if (m_operation == ObjectList::InsertOperation)
             this->remove();
         else
@@ -248,6 +324,9 @@ public:
             m_firstRedoDone = true;
             return;
         }
+        if (!this->restoreState())
+            return;
+
         if (m_operation == ObjectList::InsertOperation)
             this->insert();
         else
@@ -256,7 +335,42 @@ public:
     int id() const { return m_parentPropertyInfo->id; }
     bool mergeWith(const QUndoCommand *) { return false; }
 
+protected:
+    // CompactUndoCommand interface
+    qint64 stateSize() const
+    {
+        // The JSON object takes about as much memory as its CBOR, which is kept along with it.
+        return 2 * this->childInfoCbor().size();
+    }
+    QByteArray saveState() const { return this->childInfoCbor(); }
+    bool loadState(const QByteArray &bytes)
+    {
+        QCborParserError error;
+        const QCborValue value = QCborValue::fromCbor(bytes, &error);
+        if (error.error != QCborError::NoError || !value.isMap())
+            return false;
+
+        this->setChildInfo(value.toMap().toJsonObject());
+        m_childInfoCbor = bytes;
+        return true;
+    }
+    void releaseState() { this->setChildInfo(QJsonObject()); }
+
 private:
+    void setChildInfo(const QJsonObject &info)
+    {
+        m_childInfo = info;
+        m_childInfoCbor.clear();
+    }
+
+    // Encoded only once the stack measures or compresses this command, and then reused.
+    const QByteArray &childInfoCbor() const
+    {
+        if (m_childInfoCbor.isEmpty())
+            m_childInfoCbor = QCborValue::fromJsonValue(m_childInfo).toCbor();
+        return m_childInfoCbor;
+    }
+
     void remove()
     {
         if (m_child.isNull())
@@ -267,7 +381,7 @@ private:
 
         m_parentPropertyInfo->lock();
 
-        m_childInfo = QObjectSerializer::toJson(m_child);
+        this->setChildInfo(QObjectSerializer::toJson(m_child));
         if (m_methods.removeMethod != nullptr)
             (*m_methods.removeMethod)(m_parent, m_child);
         if (!m_child.isNull()) {
@@ -308,6 +422,7 @@ private:
     int m_childIndex = -1;
     bool m_firstRedoDone = false;
     QJsonObject m_childInfo;
+    mutable QByteArray m_childInfoCbor;
     QPointer<ChildClass> m_child;
     QPointer<ParentClass> m_parent;
     ObjectList::Operation m_operation = ObjectList::InsertOperation;
@@ -180,6 +180,11 @@ bool PdfExporter::doExport(QIODevice *device)
     textDocument.setProperty("#watermark", m_watermark);
 
     QTextDocumentPagedPrinter printer;
+    printer.setRecordPagesInParallel(
+            Application::instance()
+                    ->settings()
+                    ->value(QStringLiteral("PdfExport/recordPagesInParallel"), true)
+                    .toBool());
     printer.header()->setVisibleFromPageOne(!m_generateTitlePage);
     printer.footer()->setVisibleFromPageOne(!m_generateTitlePage);
     printer.watermark()->setVisibleFromPageOne(!m_generateTitlePage);
@@ -17,11 +17,14 @@
 #include "application.h"
 #include "scritedocument.h"
 #include "qtextdocumentpagedprinter.h"
+#include "qtextdocumentpagerecorder.h"
 
 #include <QDate>
 #include <QTime>
+#include <QThread>
 #include <QtDebug>
 #include <QPainter>
+#include <QPicture>
 #include <QDateTime>
 #include <QSettings>
 #include <QTextBlock>
@@ -350,6 +353,15 @@ QTextDocumentPagedPrinter::QTextDocumentPagedPrinter(QObject *parent) : QObject(
 
 QTextDocumentPagedPrinter::~QTextDocumentPagedPrinter() { }
 
+void QTextDocumentPagedPrinter::setRecordPagesInParallel(bool val)
+{
+    if (m_recordPagesInParallel == val)
+        return;
+
+    m_recordPagesInParallel = val;
+    emit recordPagesInParallelChanged();
+}
+
 // Much of the code in the print() function is inspired from the implementation
 // of QTextDocument::print() method implementation. Because I tried writing
 // my own print() implementation and it always sucked in stellar proportions.
@@ -535,11 +547,22 @@ bool QTextDocumentPagedPrinter::print(QTextDocument *document, QPagedPaintDevice
 
     const bool isPdfDevice = printer->paintEngine()->type() == QPaintEngine::Pdf;
 
+    // Worker threads record pages while we replay the ones already recorded. Pages of
+    // documents that the recorder can't handle are painted here, as always.
+    QTextDocumentPageRecorder recorder(doc, body);
+    recorder.setTargetDevice(printer);
+    if (m_recordPagesInParallel && QThread::idealThreadCount() > 1)
+        recorder.start();
+
     // Print away!
     while (pageNr <= toPageNr) {
         painter.save();
         painter.scale(contentScale.first, contentScale.second);
-        this->printPageContents(pageNr, toPageNr, &painter, doc, body);
+        QPicture page;
+        if (recorder.takePage(pageNr, &page))
+            painter.drawPicture(0, 0, page);
+        else
+            this->printPageContents(pageNr, toPageNr, &painter, doc, body);
         if (!isPdfDevice)
             this->printHeaderFooterWatermark(pageNr, toPageNr, &painter, doc, body);
         painter.restore();
@@ -605,20 +628,7 @@ void QTextDocumentPagedPrinter::printPageContents(int pageNr, int pageCount, QPa
 {
     Q_UNUSED(pageCount)
 
-    painter->save();
-
-    painter->translate(body.left(), body.top() - (pageNr - 1) * body.height());
-    const QRectF pageRect(0, (pageNr - 1) * body.height(), body.width(), body.height());
-
-    QAbstractTextDocumentLayout *layout = doc->documentLayout();
-    QAbstractTextDocumentLayout::PaintContext ctx;
-
-    painter->setClipRect(pageRect);
-    ctx.clip = pageRect;
-    ctx.palette.setColor(QPalette::Text, Qt::black);
-    layout->draw(painter, ctx);
-
-    painter->restore();
+    QTextDocumentPageRecorder::paintPage(painter, doc, pageNr, body);
 }
 
 void QTextDocumentPagedPrinter::printHeaderFooterWatermark(int pageNr, int pageCount,
@@ -218,6 +218,13 @@ public:
     Q_PROPERTY(Watermark* watermark READ watermark CONSTANT)
     Watermark *watermark() const { return m_watermark; }
 
+    // Pages of paginated documents are recorded on worker threads, see
+    // QTextDocumentPageRecorder, and only replayed onto the device while printing.
+    Q_PROPERTY(bool recordPagesInParallel READ isRecordPagesInParallel WRITE setRecordPagesInParallel NOTIFY recordPagesInParallelChanged)
+    void setRecordPagesInParallel(bool val);
+    bool isRecordPagesInParallel() const { return m_recordPagesInParallel; }
+    Q_SIGNAL void recordPagesInParallelChanged();
+
     Q_INVOKABLE bool print(QTextDocument *document, QPagedPaintDevice *device);
 
     static void loadSettings(HeaderFooter *header, HeaderFooter *footer, Watermark *watermark);
@@ -238,6 +245,7 @@ private:
     QTextDocument *m_textDocument = nullptr;
     QRectF m_headerRect;
     QRectF m_footerRect;
+    bool m_recordPagesInParallel = false;
 };
 
 #endif // QTEXTDOCUMENTPAGEDPRINTER_H
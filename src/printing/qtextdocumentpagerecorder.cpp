@@ -0,0 +1,282 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include "qtextdocumentpagerecorder.h"
+
+#include <QtMath>
+#include <QThread>
+#include <QPainter>
+#include <QTextBlock>
+#include <QPaintEngine>
+#include <QTextLayout>
+#include <QTextDocument>
+#include <QTextObjectInterface>
+#include <QAbstractTextDocumentLayout>
+
+Q_DECL_IMPORT int qt_defaultDpi();
+
+QTextDocumentPageRecorder::QTextDocumentPageRecorder(const QTextDocument *document,
+                                                     const QRectF &body)
+    : m_document(document), m_body(body)
+{
+    m_maxThreadCount = qMax(1, QThread::idealThreadCount());
+}
+
+QTextDocumentPageRecorder::~QTextDocumentPageRecorder()
+{
+    this->stop();
+}
+
+void QTextDocumentPageRecorder::setTargetDevice(const QPaintDevice *device)
+{
+    if (device == nullptr) {
+        m_targetIsPdf = false;
+        m_targetDpi = QSizeF();
+        return;
+    }
+
+    const QPaintEngine *engine = device->paintEngine();
+    m_targetIsPdf = engine != nullptr && engine->type() == QPaintEngine::Pdf;
+    m_targetDpi = QSizeF(device->logicalDpiX(), device->logicalDpiY());
+}
+
+bool QTextDocumentPageRecorder::start()
+{
+    if (m_document == nullptr || !m_threads.isEmpty() || m_body.isEmpty())
+        return false;
+
+    const QSizeF pageSize = m_document->pageSize();
+    const bool documentPaginated =
+            pageSize.isValid() && !pageSize.isNull() && int(pageSize.height()) != INT_MAX;
+    if (!documentPaginated)
+        return false;
+
+    // Clones are laid out against the default paint device, which must be what the
+    // document was laid out against as well.
+    if (m_document->documentLayout()->paintDevice() != nullptr)
+        return false;
+
+    m_pageCount = m_document->pageCount();
+
+    const int nrThreads = qMin(m_maxThreadCount, m_pageCount / m_minPagesPerThread);
+    if (nrThreads < 1)
+        return false;
+
+    m_pages = QVector<QPicture>(m_pageCount);
+    m_pageStates = QVector<PageState>(m_pageCount, Pending);
+    if (!this->findDirectlyPaintedPages())
+        return false;
+
+    m_stopRequested.storeRelease(0);
+
+    const int pagesPerThread = qCeil(qreal(m_pageCount) / nrThreads);
+    for (int i = 0; i < nrThreads; i++) {
+        const int fromPageNr = 1 + i * pagesPerThread;
+        const int toPageNr = qMin(m_pageCount, fromPageNr + pagesPerThread - 1);
+        if (fromPageNr > toPageNr)
+            break;
+
+        QTextDocument *clone = m_document->clone();
+        for (QTextBlock srcBlock = m_document->firstBlock(), dstBlock = clone->firstBlock();
+             srcBlock.isValid() && dstBlock.isValid();
+             srcBlock = srcBlock.next(), dstBlock = dstBlock.next()) {
+            dstBlock.layout()->setFormats(srcBlock.layout()->formats());
+        }
+
+        // Object handlers paint the clone onto a QPicture, and need to know where the
+        // picture is going to be replayed. See textScale().
+        if (m_targetDpi.isValid()) {
+            clone->setProperty("#targetIsPdf", m_targetIsPdf);
+            clone->setProperty("#targetDpi", m_targetDpi);
+        }
+
+        // The clone is laid out, painted and deleted on the worker thread. Its layout must
+        // be created there, so that the timers it uses belong to that thread.
+        QThread *thread = QThread::create([=]() { this->record(clone, fromPageNr, toPageNr); });
+        clone->moveToThread(thread);
+        m_threads.append(thread);
+        thread->start();
+    }
+
+    return true;
+}
+
+bool QTextDocumentPageRecorder::takePage(int pageNr, QPicture *picture)
+{
+    if (m_threads.isEmpty() || picture == nullptr || pageNr < 1 || pageNr > m_pageCount)
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+    while (m_pageStates.at(pageNr - 1) == Pending)
+        m_pageRecorded.wait(&m_mutex);
+
+    if (m_pageStates.at(pageNr - 1) != Recorded)
+        return false;
+
+    *picture = m_pages.at(pageNr - 1);
+    m_pages[pageNr - 1] = QPicture();
+    return true;
+}
+
+void QTextDocumentPageRecorder::stop()
+{
+    m_stopRequested.storeRelease(1);
+
+    for (QThread *thread : qAsConst(m_threads)) {
+        thread->wait();
+        delete thread;
+    }
+
+    m_threads.clear();
+    m_pages.clear();
+    m_pageStates.clear();
+}
+
+void QTextDocumentPageRecorder::paintPage(QPainter *painter, const QTextDocument *document,
+                                          int pageNr, const QRectF &body)
+{
+    painter->save();
+
+    painter->translate(body.left(), body.top() - (pageNr - 1) * body.height());
+    const QRectF pageRect(0, (pageNr - 1) * body.height(), body.width(), body.height());
+
+    QAbstractTextDocumentLayout *layout = document->documentLayout();
+    QAbstractTextDocumentLayout::PaintContext ctx;
+
+    painter->setClipRect(pageRect);
+    ctx.clip = pageRect;
+    ctx.palette.setColor(QPalette::Text, Qt::black);
+    layout->draw(painter, ctx);
+
+    painter->restore();
+}
+
+QSizeF QTextDocumentPageRecorder::textScale(const QTextDocument *document,
+                                            const QPaintDevice *device)
+{
+    if (device == nullptr)
+        return QSizeF(1, 1);
+
+    // Documents painted directly are painted onto their target device. Clones being recorded
+    // carry the target device with them.
+    bool targetIsPdf = false;
+    QSizeF targetDpi;
+    const QVariant targetDpiProperty =
+            document == nullptr ? QVariant() : document->property("#targetDpi");
+    if (targetDpiProperty.isValid()) {
+        targetIsPdf = document->property("#targetIsPdf").toBool();
+        targetDpi = targetDpiProperty.toSizeF();
+    } else {
+        const QPaintEngine *engine = device->paintEngine();
+        targetIsPdf = engine != nullptr && engine->type() == QPaintEngine::Pdf;
+        targetDpi = QSizeF(device->logicalDpiX(), device->logicalDpiY());
+    }
+
+    // Text on PDF devices is sized for the default resolution, against which documents are
+    // laid out. Text on any other device is sized for the resolution of that device.
+    const QSizeF dpi = targetIsPdf ? QSizeF(qt_defaultDpi(), qt_defaultDpi()) : targetDpi;
+    return QSizeF(dpi.width() / device->logicalDpiX(), dpi.height() / device->logicalDpiY());
+}
+
+bool QTextDocumentPageRecorder::findDirectlyPaintedPages()
+{
+    m_handlers.clear();
+
+    QList<int> objectTypes;
+    QAbstractTextDocumentLayout *layout = m_document->documentLayout();
+
+    for (QTextBlock block = m_document->begin(); block.isValid(); block = block.next()) {
+        bool paintDirectly = false;
+
+        for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+            const int objectType = it.fragment().charFormat().objectType();
+            if (objectType == QTextFormat::NoObject)
+                continue;
+
+            // Images and other objects Qt knows about need resources of the document, or
+            // a QPixmap, neither of which are to be touched on worker threads.
+            if (objectType < QTextFormat::UserObject) {
+                paintDirectly = true;
+                continue;
+            }
+
+            QTextObjectInterface *iface = layout->handlerForObject(objectType);
+            if (iface == nullptr)
+                continue;
+
+            QObject *handler = dynamic_cast<QObject *>(iface);
+            if (handler == nullptr)
+                return false;
+
+            if (!objectTypes.contains(objectType)) {
+                objectTypes.append(objectType);
+                m_handlers.append(qMakePair(objectType, handler));
+            }
+
+            if (!handler->property("#threadSafeDrawing").toBool())
+                paintDirectly = true;
+        }
+
+        if (paintDirectly) {
+            const QRectF blockRect = layout->blockBoundingRect(block);
+            const int fromPageNr = int(blockRect.top() / m_body.height()) + 1;
+            const int toPageNr = int(blockRect.bottom() / m_body.height()) + 1;
+            for (int pageNr = qMax(fromPageNr, 1); pageNr <= qMin(toPageNr, m_pageCount); pageNr++)
+                m_pageStates[pageNr - 1] = PaintDirectly;
+        }
+    }
+
+    return true;
+}
+
+void QTextDocumentPageRecorder::record(QTextDocument *clone, int fromPageNr, int toPageNr)
+{
+    QScopedPointer<QTextDocument> document(clone);
+
+    QAbstractTextDocumentLayout *layout = document->documentLayout();
+    for (const QPair<int, QObject *> &handler : qAsConst(m_handlers))
+        layout->registerHandler(handler.first, handler.second);
+
+    // Creating the layout above laid out the first few blocks without object handlers.
+    document->markContentsDirty(0, document->characterCount());
+
+    for (int pageNr = fromPageNr; pageNr <= toPageNr; pageNr++) {
+        if (m_stopRequested.loadAcquire())
+            break;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_pageStates.at(pageNr - 1) != Pending)
+                continue;
+        }
+
+        QPicture picture;
+        QPainter painter(&picture);
+        QTextDocumentPageRecorder::paintPage(&painter, document.data(), pageNr, m_body);
+        painter.end();
+
+        QMutexLocker locker(&m_mutex);
+        m_pages[pageNr - 1] = picture;
+        m_pageStates[pageNr - 1] = Recorded;
+        m_pageRecorded.wakeAll();
+    }
+
+    // Pages abandoned by stop() are left to the caller, so that takePage() doesn't wait
+    // for them forever.
+    QMutexLocker locker(&m_mutex);
+    for (int pageNr = fromPageNr; pageNr <= toPageNr; pageNr++) {
+        if (m_pageStates.at(pageNr - 1) == Pending)
+            m_pageStates[pageNr - 1] = PaintDirectly;
+    }
+    m_pageRecorded.wakeAll();
+}
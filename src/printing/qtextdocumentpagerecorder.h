@@ -0,0 +1,107 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#ifndef QTEXTDOCUMENTPAGERECORDER_H
+#define QTEXTDOCUMENTPAGERECORDER_H
+
+#include <QList>
+#include <QPair>
+#include <QRectF>
+#include <QMutex>
+#include <QVector>
+#include <QPicture>
+#include <QAtomicInt>
+#include <QWaitCondition>
+
+class QThread;
+class QPainter;
+class QPaintDevice;
+class QTextDocument;
+
+/**
+ * Records pages of a paginated QTextDocument into QPicture display lists on worker threads,
+ * so that the thread printing the document only has to replay them onto its printer.
+ *
+ * QTextDocument cannot be laid out or painted from more than one thread at a time. Each
+ * worker therefore gets its own clone of the document, lays it out and records a contiguous
+ * range of pages from it. Object handlers registered on the document are shared with the
+ * clones, so their intrinsicSize() must be safe to call from worker threads. Objects are
+ * drawn on worker threads only if their handler has a true "#threadSafeDrawing" property.
+ * Pages with any other object are left for the caller to paint from the document itself.
+ *
+ * Recorded objects are painted onto a QPicture, not onto the device the page ends up on.
+ * Handlers that adjust what they draw to that device must ask textScale() how, instead of
+ * looking at the device of their painter.
+ *
+ * Documents that are not paginated, or are laid out against a specific paint device, are
+ * not recorded at all. Neither are documents too short to benefit from it.
+ */
+class QTextDocumentPageRecorder
+{
+public:
+    QTextDocumentPageRecorder(const QTextDocument *document, const QRectF &body);
+    ~QTextDocumentPageRecorder();
+
+    void setMaxThreadCount(int val) { m_maxThreadCount = qMax(1, val); }
+    int maxThreadCount() const { return m_maxThreadCount; }
+
+    void setMinPagesPerThread(int val) { m_minPagesPerThread = qMax(1, val); }
+    int minPagesPerThread() const { return m_minPagesPerThread; }
+
+    // Device onto which recorded pages are going to be replayed. Must be set before start().
+    void setTargetDevice(const QPaintDevice *device);
+
+    // Starts recording pages in the background. Returns false if pages of the document
+    // cannot (or need not) be recorded, in which case the caller paints all pages.
+    bool start();
+    bool isStarted() const { return !m_threads.isEmpty(); }
+
+    // Waits for the page to be recorded and moves it into picture. Returns false if the page
+    // has to be painted by the caller with paintPage().
+    bool takePage(int pageNr, QPicture *picture);
+
+    // Abandons pages not recorded yet, and waits for worker threads to finish.
+    void stop();
+
+    static void paintPage(QPainter *painter, const QTextDocument *document, int pageNr,
+                          const QRectF &body);
+
+    // Scale that object handlers must apply to text they draw from the document onto the
+    // device, so that it comes out the same whether the page is painted or recorded.
+    static QSizeF textScale(const QTextDocument *document, const QPaintDevice *device);
+
+private:
+    enum PageState { Pending, Recorded, PaintDirectly };
+
+    bool findDirectlyPaintedPages();
+    void record(QTextDocument *clone, int fromPageNr, int toPageNr);
+
+private:
+    const QTextDocument *m_document = nullptr;
+    QRectF m_body;
+    int m_pageCount = 0;
+    int m_maxThreadCount = 1;
+    int m_minPagesPerThread = 8;
+    bool m_targetIsPdf = false;
+    QSizeF m_targetDpi;
+    QList<QThread *> m_threads;
+    QList<QPair<int, QObject *>> m_handlers;
+
+    QMutex m_mutex;
+    QWaitCondition m_pageRecorded;
+    QAtomicInt m_stopRequested;
+    QVector<QPicture> m_pages;
+    QVector<PageState> m_pageStates;
+};
+
+#endif // QTEXTDOCUMENTPAGERECORDER_H
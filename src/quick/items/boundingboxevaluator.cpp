@@ -16,9 +16,7 @@
 #include "boundingboxevaluator.h"
 #include "boundingboxevaluator.h"
 
-#include <QBuffer>
 #include <QPainter>
-#include <QJsonDocument>
 #include <QFutureWatcher>
 #include <QtConcurrentRun>
 #include <QtConcurrentMap>
@@ -69,12 +67,6 @@ void BoundingBoxEvaluator::setPreviewScale(qreal val)
     emit previewScaleChanged();
 }
 
-QPicture BoundingBoxEvaluator::preview() const
-{
-    QMutexLocker locker(&m_previewLock);
-    return m_preview;
-}
-
 void BoundingBoxEvaluator::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_evaluationTimer.timerId()) {
@@ -136,128 +128,67 @@ void BoundingBoxEvaluator::updatePreview()
 #ifndef QT_NO_DEBUG_OUTPUT
     qDebug("BoundingBoxEvaluator is updating preview picture");
 #endif
-    if (!m_preview.isNull())
-        return;
-
-    const QString futureWatcherName = QStringLiteral("CreatePreviewPictureFuture");
-    if (this->findChild<QFutureWatcherBase *>(futureWatcherName) != nullptr)
-        return;
 
     /**
-     * Previously we were spawning a thread to run a function which created the preview picture.
-     * That seems like a rather bad idea, because the function (which runs in a thread) will
-     * have to dereference BoundingBoxItem instances in m_items, which could have gotten
-     * deleted by the time the preview is evaluated.
+     * Previews are painted on a background thread, which must not dereference BoundingBoxItem
+     * instances in m_items, because they could get deleted by the time the preview is painted.
      *
-     * To address that issue, we now serialize BoundingBoxItems into a JSON array and then
-     * get a function to create preview-picture in a thread.
+     * Items used to be serialized into JSON for this, with their live previews encoded as
+     * base64 PNG, only to be decoded again on the background thread. Snapshots instead share
+     * the preview image each item already has, and take next to nothing to capture.
      */
-    QList<QJsonObject> itemInfoArray;
+    QVector<BoundingBoxItemSnapshot> items;
+    items.reserve(m_items.size());
     for (BoundingBoxItem *item : qAsConst(m_items))
-        itemInfoArray << item->asJson();
-
-    QFuture<QPicture> future = QtConcurrent::run(
-            &m_threadPool,
-            [=](const QList<QJsonObject> &items, const QRectF &bbox,
-                const qreal scale) -> QPicture {
-                QMutexLocker locker(&m_previewLock);
-                return BoundingBoxEvaluator::createPreviewPicture(items, bbox, scale);
-            },
-            itemInfoArray, m_boundingBox, m_previewScale);
-    QFutureWatcher<QPicture> *futureWatcher = new QFutureWatcher<QPicture>(this);
-    futureWatcher->setObjectName(futureWatcherName);
-    connect(futureWatcher, &QFutureWatcher<QPicture>::finished, this, [=]() {
-        m_preview = future.result();
-        futureWatcher->deleteLater();
-        emit previewUpdated();
-    });
-    futureWatcher->setFuture(future);
-}
-
-QPicture BoundingBoxEvaluator::createPreviewPicture(const QList<QJsonObject> &items,
-                                                    const QRectF &bbox, const qreal scale)
-{
-    // Make a copy, so we can sort the copy by stack order.
-    QList<QJsonObject> itemsCopy = items;
-
-    QSizeF boxSize = bbox.size();
-    boxSize *= scale;
-    if (boxSize.isEmpty())
-        return QPicture();
+        items.append(item->snapshot());
 
-    const QString stackOrderAttrib = QStringLiteral("stackOrder");
+    std::stable_sort(items.begin(), items.end(),
+                     [](const BoundingBoxItemSnapshot &e1, const BoundingBoxItemSnapshot &e2) {
+                         return e1.stackOrder < e2.stackOrder;
+                     });
 
-    auto lessThan = [stackOrderAttrib](const QJsonObject &e1, const QJsonObject &e2) -> bool {
-        return e1.value(stackOrderAttrib).toDouble() < e2.value(stackOrderAttrib).toDouble();
-    };
-    std::sort(itemsCopy.begin(), itemsCopy.end(), lessThan);
-
-    QPicture picture;
-    picture.setBoundingRect(QRectF(QPointF(0, 0), boxSize).toRect());
-
-    QTransform tx;
-    tx.translate(-bbox.left(), -bbox.top());
-    tx.scale(scale, scale);
-
-    QPainter paint(&picture);
-    paint.setRenderHint(QPainter::Antialiasing);
-    paint.setRenderHint(QPainter::SmoothPixmapTransform);
-    paint.setTransform(tx);
-
-    auto rectFromJson = [](const QJsonObject &jsRect) {
-        return QRectF(jsRect.value(QStringLiteral("x")).toDouble(),
-                      jsRect.value(QStringLiteral("y")).toDouble(),
-                      jsRect.value(QStringLiteral("width")).toDouble(),
-                      jsRect.value(QStringLiteral("height")).toDouble());
-    };
-
-    auto imageFromJson = [](const QJsonValue &value) {
-        if (value.isNull() || value.isUndefined())
-            return QImage();
-
-        const QByteArray base64 = value.toString().toLatin1();
-        QByteArray bytes = QByteArray::fromBase64(base64);
-        QBuffer buffer(&bytes);
-        buffer.open(QFile::ReadOnly);
-
-        QImage ret;
-        ret.load(&buffer, "PNG");
+    m_previewItems = items;
+    m_previewBoundingBox = m_boundingBox;
+    emit previewUpdated();
+}
 
-        return ret;
-    };
+void BoundingBoxEvaluator::paintPreview(QPainter *painter,
+                                        const QVector<BoundingBoxItemSnapshot> &items,
+                                        const QRectF &bbox, const QRectF &targetRect)
+{
+    if (bbox.isEmpty() || targetRect.isEmpty())
+        return;
 
-    for (const QJsonObject &item : qAsConst(itemsCopy)) {
-        const QRectF itemRect = rectFromJson(item.value(QStringLiteral("boundingRect")).toObject());
-        const bool isLivePreview = item.value(QStringLiteral("livePreview")).toBool();
-        const QImage itemPreview =
-                isLivePreview ? imageFromJson(item.value(QStringLiteral("preview"))) : QImage();
-        const QColor previewBorderColor(
-                item.value(QStringLiteral("previewBorderColor")).toString());
-        const QColor previewFillColor(item.value(QStringLiteral("previewFillColor")).toString());
-        const qreal previewBorderWidth =
-                item.value(QStringLiteral("previewBorderWidth")).toDouble();
-
-        if (isLivePreview && !itemPreview.isNull())
-            paint.drawImage(itemRect, itemPreview);
-        else if (previewBorderColor.alpha() > 0 || previewFillColor.alpha() > 0) {
-            QPen pen(previewBorderColor);
+    QSizeF previewSize = bbox.size();
+    previewSize.scale(targetRect.size(), Qt::KeepAspectRatio);
+    const qreal scale = previewSize.width() / bbox.width();
+
+    painter->save();
+    painter->translate(targetRect.topLeft());
+    painter->scale(scale, scale);
+    painter->translate(-bbox.topLeft());
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+    for (const BoundingBoxItemSnapshot &item : items) {
+        if (item.livePreview && !item.preview.isNull())
+            painter->drawImage(item.rect, item.preview);
+        else if (item.borderColor.alpha() > 0 || item.fillColor.alpha() > 0) {
+            QPen pen(item.borderColor);
             pen.setCosmetic(true);
-            pen.setWidthF(previewBorderWidth);
+            pen.setWidthF(item.borderWidth);
 
-            paint.setPen(pen);
-            paint.setBrush(QBrush(previewFillColor));
-            paint.drawRect(itemRect);
+            painter->setPen(pen);
+            painter->setBrush(QBrush(item.fillColor));
+            painter->drawRect(item.rect);
         }
     }
 
-    paint.end();
-
-    return picture;
+    painter->restore();
 }
 
 void BoundingBoxEvaluator::markPreviewDirty()
 {
-    m_preview = QPicture();
     m_updatePreviewTimer.start(100, this);
 }
 
@@ -276,35 +207,15 @@ BoundingBoxItem::BoundingBoxItem(QObject *parent)
         connect(m_item, &QQuickItem::widthChanged, this, &BoundingBoxItem::requestReevaluation);
         connect(m_item, &QQuickItem::heightChanged, this, &BoundingBoxItem::requestReevaluation);
 
-        connect(m_item, &QQuickItem::xChanged, &m_jsonUpdateTimer, QOverload<>::of(&QTimer::start));
-        connect(m_item, &QQuickItem::yChanged, &m_jsonUpdateTimer, QOverload<>::of(&QTimer::start));
-        connect(m_item, &QQuickItem::widthChanged, &m_jsonUpdateTimer,
-                QOverload<>::of(&QTimer::start));
-        connect(m_item, &QQuickItem::heightChanged, &m_jsonUpdateTimer,
-                QOverload<>::of(&QTimer::start));
+        // Moving an item doesn't change what it looks like, resizing it does.
+        connect(m_item, &QQuickItem::widthChanged, this, &BoundingBoxItem::updatePreviewLater);
+        connect(m_item, &QQuickItem::heightChanged, this, &BoundingBoxItem::updatePreviewLater);
 
         connect(m_item, &QQuickItem::xChanged, this, &BoundingBoxItem::determineVisibility);
         connect(m_item, &QQuickItem::yChanged, this, &BoundingBoxItem::determineVisibility);
         connect(m_item, &QQuickItem::widthChanged, this, &BoundingBoxItem::determineVisibility);
         connect(m_item, &QQuickItem::heightChanged, this, &BoundingBoxItem::determineVisibility);
     }
-
-    connect(this, &BoundingBoxItem::stackOrderChanged, &m_jsonUpdateTimer,
-            QOverload<>::of(&QTimer::start));
-    connect(this, &BoundingBoxItem::previewFillColorChanged, &m_jsonUpdateTimer,
-            QOverload<>::of(&QTimer::start));
-    connect(this, &BoundingBoxItem::previewBorderColorChanged, &m_jsonUpdateTimer,
-            QOverload<>::of(&QTimer::start));
-    connect(this, &BoundingBoxItem::previewBorderWidthChanged, &m_jsonUpdateTimer,
-            QOverload<>::of(&QTimer::start));
-    connect(this, &BoundingBoxItem::livePreviewChanged, &m_jsonUpdateTimer,
-            QOverload<>::of(&QTimer::start));
-    connect(this, &BoundingBoxItem::previewUpdated, &m_jsonUpdateTimer,
-            QOverload<>::of(&QTimer::start));
-
-    m_jsonUpdateTimer.setInterval(0);
-    m_jsonUpdateTimer.setSingleShot(true);
-    connect(&m_jsonUpdateTimer, &QTimer::timeout, this, [=]() { m_json = this->toJson(); });
 }
 
 BoundingBoxItem::~BoundingBoxItem()
@@ -350,7 +261,7 @@ void BoundingBoxItem::setStackOrder(qreal val)
     m_stackOrder = val;
     emit stackOrderChanged();
 
-    this->updatePreviewLater();
+    this->requestPreviewRepaint();
 }
 
 void BoundingBoxItem::setPreviewFillColor(const QColor &val)
@@ -361,7 +272,7 @@ void BoundingBoxItem::setPreviewFillColor(const QColor &val)
     m_previewFillColor = val;
     emit previewFillColorChanged();
 
-    this->updatePreviewLater();
+    this->requestPreviewRepaint();
 }
 
 void BoundingBoxItem::setPreviewBorderColor(const QColor &val)
@@ -372,7 +283,7 @@ void BoundingBoxItem::setPreviewBorderColor(const QColor &val)
     m_previewBorderColor = val;
     emit previewBorderColorChanged();
 
-    this->updatePreviewLater();
+    this->requestPreviewRepaint();
 }
 
 void BoundingBoxItem::setPreviewBorderWidth(qreal val)
@@ -383,7 +294,7 @@ void BoundingBoxItem::setPreviewBorderWidth(qreal val)
     m_previewBorderWidth = val;
     emit previewBorderWidthChanged();
 
-    this->updatePreviewLater();
+    this->requestPreviewRepaint();
 }
 
 void BoundingBoxItem::setLivePreview(bool val)
@@ -446,34 +357,17 @@ void BoundingBoxItem::markPreviewDirty()
     this->updatePreviewLater();
 }
 
-QJsonObject BoundingBoxItem::toJson() const
+BoundingBoxItemSnapshot BoundingBoxItem::snapshot() const
 {
-    QJsonObject ret;
-
-    ret.insert(QStringLiteral("stackOrder"), m_stackOrder);
-    ret.insert(QStringLiteral("previewFillColor"), m_previewFillColor.name(QColor::HexArgb));
-    ret.insert(QStringLiteral("previewBorderColor"), m_previewBorderColor.name(QColor::HexArgb));
-    ret.insert(QStringLiteral("previewBorderWidth"), m_previewBorderWidth);
-    ret.insert(QStringLiteral("livePreview"), m_livePreview);
-
-    const QRectF bRect = this->boundingRect();
-
-    QJsonObject jsRect;
-    jsRect.insert(QStringLiteral("x"), bRect.x());
-    jsRect.insert(QStringLiteral("y"), bRect.y());
-    jsRect.insert(QStringLiteral("width"), bRect.width());
-    jsRect.insert(QStringLiteral("height"), bRect.height());
-    ret.insert(QStringLiteral("boundingRect"), jsRect);
-
-    if (m_livePreview) {
-        QByteArray bytes;
-        QBuffer buffer(&bytes);
-        buffer.open(QIODevice::WriteOnly);
-        m_preview.save(&buffer, "PNG"); // writes image into ba in PNG format
-        bytes = bytes.toBase64();
-        ret.insert(QStringLiteral("preview"), QString::fromLatin1(bytes));
-    }
-
+    BoundingBoxItemSnapshot ret;
+    ret.rect = this->boundingRect();
+    ret.stackOrder = m_stackOrder;
+    ret.fillColor = m_previewFillColor;
+    ret.borderColor = m_previewBorderColor;
+    ret.borderWidth = m_previewBorderWidth;
+    ret.livePreview = m_livePreview;
+    if (m_livePreview)
+        ret.preview = m_preview;
     return ret;
 }
 
@@ -489,8 +383,13 @@ void BoundingBoxItem::requestReevaluation()
 {
     if (m_evaluator)
         m_evaluator->markDirty(this);
+}
 
-    this->updatePreviewLater();
+void BoundingBoxItem::requestPreviewRepaint()
+{
+    // Only the evaluator's preview changes, the preview of this item remains as it is.
+    if (m_evaluator)
+        m_evaluator->markPreviewDirty();
 }
 
 void BoundingBoxItem::resetEvaluator()
@@ -620,11 +519,6 @@ void BoundingBoxItem::determineVisibility()
     emit itemVisibilityChanged();
 }
 
-void BoundingBoxItem::updateJson()
-{
-    m_json = this->toJson();
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 
 BoundingBoxPreview::BoundingBoxPreview(QQuickItem *parent)
@@ -689,12 +583,20 @@ void BoundingBoxPreview::updatePreviewImage()
     if (m_evaluator == nullptr)
         return;
 
-    auto capturePreviewAsPicture = [=]() -> QImage {
-        const QRectF pictureRect(0, 0, this->width(), this->height());
+    // Snapshots of items are copied here, so that the preview is painted from what they were
+    // at this point in time, even if the evaluator changes them in the meantime.
+    const QSizeF pictureSize(this->width(), this->height());
+    const QColor backgroundColor = m_backgroundColor;
+    const qreal backgroundOpacity = m_backgroundOpacity;
+    const QVector<BoundingBoxItemSnapshot> items = m_evaluator->previewItems();
+    const QRectF bbox = m_evaluator->previewBoundingBox();
+
+    auto capturePreviewAsImage = [=]() -> QImage {
+        const QRectF pictureRect(QPointF(0, 0), pictureSize);
 
         /**
-         * Why capture the preview in a QImage now? Why not QPicture?
-         * ----------------------------------------------------------
+         * Why capture the preview in a QImage now?
+         * ----------------------------------------
          *
          * Painting a QPicture on screen takes more time than painting a
          * QImage. When measured on a MacBook Pro, I noticed that painting
@@ -711,45 +613,39 @@ void BoundingBoxPreview::updatePreviewImage()
         image.setDevicePixelRatio(2.0);
         image.fill(Qt::transparent);
 
-        QPicture preview = m_evaluator->preview();
-        if (preview.isNull())
+        if (items.isEmpty() || bbox.isEmpty())
             return image;
 
         QPainter painter(&image);
-        painter.setOpacity(m_backgroundOpacity);
-        painter.fillRect(pictureRect, m_backgroundColor);
+        painter.setOpacity(backgroundOpacity);
+        painter.fillRect(pictureRect, backgroundColor);
         painter.setOpacity(1.0);
 
-        QSizeF previewSize = preview.boundingRect().size();
-        previewSize.scale(pictureRect.size(), Qt::KeepAspectRatio);
-
-        QRectF previewRect(QPointF(0, 0), previewSize);
-        // previewRect.moveCenter(itemRect.center());
-
-        painter.translate(previewRect.topLeft());
-
-        const qreal sx = previewSize.width() / preview.boundingRect().width();
-        const qreal sy = previewSize.height() / preview.boundingRect().height();
-        painter.scale(sx, sy);
-
-        painter.setRenderHint(QPainter::Antialiasing, true);
-        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
-        preview.play(&painter);
+        BoundingBoxEvaluator::paintPreview(&painter, items, bbox, pictureRect);
 
         return image;
     };
 
+    // Previews asked for while one is being painted are painted once it is done.
     const QString futureWatcherName = QStringLiteral("RedrawFutureWatcher");
-    if (this->findChild<QFutureWatcherBase *>(futureWatcherName) != nullptr)
+    if (this->findChild<QFutureWatcherBase *>(futureWatcherName) != nullptr) {
+        m_previewImageOutdated = true;
         return;
+    }
+
+    m_previewImageOutdated = false;
 
-    QFuture<QImage> future = QtConcurrent::run(&m_evaluator->m_threadPool, capturePreviewAsPicture);
+    QFuture<QImage> future = QtConcurrent::run(&m_evaluator->m_threadPool, capturePreviewAsImage);
     QFutureWatcher<QImage> *futureWatcher = new QFutureWatcher<QImage>(this);
     futureWatcher->setObjectName(futureWatcherName);
     connect(futureWatcher, &QFutureWatcher<QImage>::finished, this, [=]() {
         m_previewImage = future.result();
+        futureWatcher->setObjectName(QString());
         futureWatcher->deleteLater();
         this->update();
+
+        if (m_previewImageOutdated)
+            this->updatePreviewImage();
     });
     futureWatcher->setFuture(future);
 }
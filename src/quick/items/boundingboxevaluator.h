@@ -16,16 +16,15 @@
 
 #include "execlatertimer.h"
 
+#include <QColor>
 #include <QRectF>
 #include <QImage>
-#include <QMutex>
 #include <QObject>
-#include <QPicture>
+#include <QVector>
 #include <QPointer>
 #include <QQmlEngine>
 #include <QQuickItem>
 #include <QThreadPool>
-#include <QJsonObject>
 #include <QQuickPaintedItem>
 
 #include "qobjectproperty.h"
@@ -37,6 +36,23 @@
  * why this class.
  */
 class BoundingBoxItem;
+
+/**
+ * What it takes to paint a BoundingBoxItem into the preview of its evaluator. Snapshots are
+ * plain values, and share the preview image of the item instead of copying it. They can be
+ * painted on any thread, even after the item itself is gone.
+ */
+struct BoundingBoxItemSnapshot
+{
+    QRectF rect;
+    qreal stackOrder = 0;
+    QColor fillColor = Qt::white;
+    QColor borderColor = Qt::black;
+    qreal borderWidth = 1;
+    bool livePreview = true;
+    QImage preview;
+};
+
 class BoundingBoxEvaluator : public QObject
 {
     Q_OBJECT
@@ -87,6 +103,8 @@ public:
     QRectF initialRect() const { return m_initialRect; }
     Q_SIGNAL void initialRectChanged();
 
+    // Size, relative to the item, at which live previews of items are grabbed. The preview
+    // of the whole bounding box is painted to fit whatever shows it, see paintPreview().
     Q_PROPERTY(qreal previewScale READ previewScale WRITE setPreviewScale NOTIFY previewScaleChanged)
     void setPreviewScale(qreal val);
     qreal previewScale() const { return m_previewScale; }
@@ -96,7 +114,9 @@ public:
     int itemCount() const { return m_items.size(); }
     Q_SIGNAL void itemCountChanged();
 
-    QPicture preview() const;
+    // Snapshots of all items sorted by stack order, as of the last preview update.
+    QVector<BoundingBoxItemSnapshot> previewItems() const { return m_previewItems; }
+    QRectF previewBoundingBox() const { return m_previewBoundingBox; }
     Q_INVOKABLE void markPreviewDirty();
     Q_SIGNAL void previewUpdated();
 
@@ -109,8 +129,10 @@ protected:
     void evaluateNow();
 
     void updatePreview();
-    static QPicture createPreviewPicture(const QList<QJsonObject> &items, const QRectF &bbox,
-                                         const qreal scale);
+
+    // Fits bbox into targetRect, so that previews come out sharp at any size.
+    static void paintPreview(QPainter *painter, const QVector<BoundingBoxItemSnapshot> &items,
+                             const QRectF &bbox, const QRectF &targetRect);
 
 private:
     void addItem(BoundingBoxItem *item);
@@ -122,12 +144,12 @@ private:
     friend class BoundingBoxPreview;
 
     qreal m_margin = 0;
-    QPicture m_preview;
     qreal m_previewScale = 1.0;
     QRectF m_initialRect;
     QRectF m_boundingBox;
     QThreadPool m_threadPool;
-    mutable QMutex m_previewLock;
+    QRectF m_previewBoundingBox;
+    QVector<BoundingBoxItemSnapshot> m_previewItems;
     ExecLaterTimer m_evaluationTimer;
     ExecLaterTimer m_updatePreviewTimer;
     QList<BoundingBoxItem *> m_items;
@@ -217,29 +239,26 @@ public:
 
     Q_SIGNAL void itemVisibilityChanged();
 
-    QJsonObject asJson() const { return m_json; }
+    BoundingBoxItemSnapshot snapshot() const;
 
 protected:
     void timerEvent(QTimerEvent *event);
 
 private:
     void requestReevaluation();
+    void requestPreviewRepaint();
     void resetEvaluator();
     void resetViewportItem();
     void updatePreview();
     void updatePreviewLater();
     void setPreview(const QImage &image);
     void determineVisibility();
-    void updateJson();
-    QJsonObject toJson() const;
 
 private:
     QImage m_preview;
     qreal m_stackOrder = 0;
     bool m_livePreview = true;
     QRectF m_viewportRect;
-    QJsonObject m_json;
-    QTimer m_jsonUpdateTimer;
     QPointer<QQuickItem> m_item;
     qreal m_previewBorderWidth = 1;
     QColor m_previewFillColor = Qt::white;
@@ -285,6 +304,7 @@ private:
 
 private:
     QImage m_previewImage;
+    bool m_previewImageOutdated = false;
     QColor m_backgroundColor = Qt::white;
     qreal m_backgroundOpacity = 1.0;
     QObjectProperty<BoundingBoxEvaluator> m_evaluator;
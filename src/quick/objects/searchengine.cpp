@@ -18,6 +18,7 @@
 #include <QJsonObject>
 #include <QTextCursor>
 #include <QTimerEvent>
+#include <QElapsedTimer>
 
 SearchAgent::SearchAgent(QObject *parent)
     : QObject(parent), m_engine(this, "engine"), m_textDocument(this, "textDocument")
@@ -192,7 +193,8 @@ void SearchAgent::onClearSearchRequest()
 SearchEngine::SearchEngine(QObject *parent)
     : QObject(parent),
       m_searchTimer("SearchEngine.m_searchTimer"),
-      m_searchAgentSortTimer("SearchEngine.m_searchAgentSortTimer")
+      m_searchAgentSortTimer("SearchEngine.m_searchAgentSortTimer"),
+      m_searchBatchTimer("SearchEngine.m_searchBatchTimer")
 {
 }
 
@@ -254,6 +256,9 @@ void SearchEngine::replaceAll(const QString &string)
 {
     HourGlass hourGlass;
 
+    // Agents that have not been searched yet must get a chance to replace too
+    this->finishSearch();
+
     if (m_searchResults.isEmpty())
         return;
 
@@ -300,7 +305,8 @@ void SearchEngine::cycleSearchResult()
     }
 }
 
-QJsonArray SearchEngine::indexesOf(const QString &of, const QString &in, int givenFlags)
+QVector<QPair<int, int>> SearchEngine::matchRanges(const QString &of, const QString &in,
+                                                   int givenFlags)
 {
     SearchEngine::SearchFlags flags(givenFlags);
     Qt::CaseSensitivity cs = Qt::CaseInsensitive;
@@ -308,14 +314,10 @@ QJsonArray SearchEngine::indexesOf(const QString &of, const QString &in, int giv
     if (flags.testFlag(SearchEngine::SearchCaseSensitively))
         cs = Qt::CaseSensitive;
 
-    auto createResultItem = [](int from, int to) {
-        QJsonObject item;
-        item.insert("from", from);
-        item.insert("to", to);
-        return item;
-    };
+    QVector<QPair<int, int>> ret;
+    if (of.isEmpty())
+        return ret;
 
-    QJsonArray ret;
     int from = 0;
     while (1) {
         int pos = in.indexOf(of, from, cs);
@@ -324,9 +326,9 @@ QJsonArray SearchEngine::indexesOf(const QString &of, const QString &in, int giv
 
         if (flags.testFlag(SearchEngine::SearchWholeWords)) {
             if (pos + of.length() >= in.length() || in.at(pos + of.length()).isSpace())
-                ret.append(createResultItem(pos, pos + of.length() - 1));
+                ret.append(qMakePair(pos, pos + of.length() - 1));
         } else
-            ret.append(createResultItem(pos, pos + of.length() - 1));
+            ret.append(qMakePair(pos, pos + of.length() - 1));
 
         from = pos + of.length();
     }
@@ -334,6 +336,21 @@ QJsonArray SearchEngine::indexesOf(const QString &of, const QString &in, int giv
     return ret;
 }
 
+QJsonArray SearchEngine::indexesOf(const QString &of, const QString &in, int flags)
+{
+    const QVector<QPair<int, int>> ranges = SearchEngine::matchRanges(of, in, flags);
+
+    QJsonArray ret;
+    for (const QPair<int, int> &range : ranges) {
+        QJsonObject item;
+        item.insert(QStringLiteral("from"), range.first);
+        item.insert(QStringLiteral("to"), range.second);
+        ret.append(item);
+    }
+
+    return ret;
+}
+
 QString SearchEngine::createMarkupText(const QString &text, int from, int to, const QBrush &bg,
                                        const QBrush &fg)
 {
@@ -357,6 +374,11 @@ void SearchEngine::timerEvent(QTimerEvent *event)
         m_searchTimer.stop();
         this->doSearch();
     }
+
+    if (event->timerId() == m_searchBatchTimer.timerId()) {
+        m_searchBatchTimer.stop();
+        this->searchNextBatch();
+    }
 }
 
 void SearchEngine::addSearchAgent(SearchAgent *ptr)
@@ -381,6 +403,7 @@ void SearchEngine::removeSearchAgent(SearchAgent *ptr)
         return;
 
     m_searchAgents.removeAt(index);
+    m_pendingSearchAgents.removeAll(ptr);
 
     const int oldSearchResultCount = m_searchResults.size();
     for (int i = m_searchResults.size() - 1; i >= 0; i--) {
@@ -427,7 +450,8 @@ int SearchEngine::staticSearchAgentCount(QQmlListProperty<SearchAgent> *list)
 
 void SearchEngine::doSearch()
 {
-    HourGlass hourGlass;
+    m_searchBatchTimer.stop();
+    m_pendingSearchAgents.clear();
 
     if (!m_searchResults.isEmpty()) {
         SearchAgent *agent = nullptr;
@@ -453,10 +477,35 @@ void SearchEngine::doSearch()
         m_searchAgentSortTimer.stop();
     }
 
-    if (m_searchString.isEmpty())
+    if (m_searchString.isEmpty()) {
+        this->setSearching(false);
         return;
+    }
+
+    m_pendingSearchAgents = m_searchAgents;
+    this->setSearching(true);
+    this->searchNextBatch();
+}
+
+void SearchEngine::searchNextBatch()
+{
+    /**
+     * A long screenplay can have thousands of agents, and each of them searches on the
+     * GUI thread. Instead of blocking the find bar until all of them are done, we ask as
+     * many agents as fit in a short time slice and let the event loop run in between.
+     * Results are published after every slice, and the first one is made current as soon
+     * as it is found.
+     */
+    const qint64 maxSliceTime = 10; // ms
+
+    QElapsedTimer sliceTimer;
+    sliceTimer.start();
+
+    const int oldSearchResultCount = m_searchResults.size();
+
+    while (!m_pendingSearchAgents.isEmpty()) {
+        SearchAgent *agent = m_pendingSearchAgents.takeFirst();
 
-    for (SearchAgent *agent : qAsConst(m_searchAgents)) {
         // Ask the agent to perform search
         agent->searchRequest(m_searchString);
 
@@ -468,12 +517,39 @@ void SearchEngine::doSearch()
         }
 
         agent->setCurrentSearchResultIndex(-1);
+
+        if (sliceTimer.elapsed() >= maxSliceTime)
+            break;
     }
 
-    emit searchResultCountChanged();
+    if (m_searchResults.size() != oldSearchResultCount) {
+        emit searchResultCountChanged();
 
-    if (!m_searchResults.isEmpty())
-        this->setCurrentSearchResultIndex(0);
+        if (m_currentSearchResultIndex < 0)
+            this->setCurrentSearchResultIndex(0);
+    }
+
+    if (m_pendingSearchAgents.isEmpty())
+        this->setSearching(false);
+    else
+        m_searchBatchTimer.start(0, this);
+}
+
+void SearchEngine::finishSearch()
+{
+    while (!m_pendingSearchAgents.isEmpty())
+        this->searchNextBatch();
+
+    m_searchBatchTimer.stop();
+}
+
+void SearchEngine::setSearching(bool val)
+{
+    if (m_searching == val)
+        return;
+
+    m_searching = val;
+    emit searchingChanged();
 }
 
 void SearchEngine::doSearchLater()
@@ -15,6 +15,7 @@
 #define SEARCHENGINE_H
 
 #include <QObject>
+#include <QVector>
 #include <QJsonArray>
 #include <QQmlEngine>
 #include <QQuickTextDocument>
@@ -146,6 +147,11 @@ public:
     int currentSearchResultIndex() const { return m_currentSearchResultIndex; }
     Q_SIGNAL void currentSearchResultIndexChanged();
 
+    // True while search agents are still being asked for results of the current search string.
+    Q_PROPERTY(bool searching READ isSearching NOTIFY searchingChanged)
+    bool isSearching() const { return m_searching; }
+    Q_SIGNAL void searchingChanged();
+
     Q_INVOKABLE void replace(const QString &string);
     Q_INVOKABLE void replaceAll(const QString &string);
 
@@ -154,6 +160,10 @@ public:
     Q_INVOKABLE void previousSearchResult();
     Q_INVOKABLE void cycleSearchResult();
 
+    // Returns [from, to] ranges of matches, where 'to' is inclusive.
+    static QVector<QPair<int, int>> matchRanges(const QString &of, const QString &in, int flags);
+
+    // JSON form of matchRanges(), for use in QML
     static QJsonArray indexesOf(const QString &of, const QString &in, int flags);
     static QString createMarkupText(const QString &text, int from, int to, const QBrush &bg,
                                     const QBrush &fg);
@@ -171,6 +181,9 @@ private:
 
     void doSearch();
     void doSearchLater();
+    void searchNextBatch();
+    void finishSearch();
+    void setSearching(bool val);
     void setCurrentSearchResultIndex(int val);
 
 private:
@@ -184,6 +197,9 @@ private:
     ExecLaterTimer m_searchAgentSortTimer;
     QList<SearchAgent *> m_searchAgents;
     QList<QPair<SearchAgent *, int>> m_searchResults;
+    bool m_searching = false;
+    ExecLaterTimer m_searchBatchTimer;
+    QList<SearchAgent *> m_pendingSearchAgents;
 };
 
 class TextDocumentSearch : public QObject
@@ -677,10 +677,11 @@ QStringList
 SpellCheckSyntaxHighlighterDelegate::spellingSuggestionsForWordAt(int cursorPosition) const
 {
     TextFragment fragment;
-    if (!this->findMisspelledTextFragment(cursorPosition, fragment))
+    QString word;
+    if (!this->findMisspelledTextFragment(cursorPosition, fragment, &word))
         return QStringList();
 
-    return fragment.suggestions();
+    return SpellCheckService::suggestions(word);
 }
 
 void SpellCheckSyntaxHighlighterDelegate::replaceWordAt(int cursorPosition, const QString &with)
@@ -726,9 +727,19 @@ void SpellCheckSyntaxHighlighterDelegate::addWordAtPositionToIgnoreList(int curs
 void SpellCheckSyntaxHighlighterDelegate::checkForSpellingMistakeInCurrentWord()
 {
     TextFragment fragment;
-    if (m_cursorPosition >= 0 && this->findMisspelledTextFragment(m_cursorPosition, fragment)) {
+    QString word;
+    if (m_cursorPosition >= 0
+        && this->findMisspelledTextFragment(m_cursorPosition, fragment, &word)) {
         this->setWordUnderCursorIsMisspelled(true);
-        this->setSpellingSuggestionsForWordUnderCursor(fragment.suggestions());
+        this->setSpellingSuggestionsForWordUnderCursor(QStringList());
+
+        const int position = m_cursorPosition;
+        SpellCheckService::requestSuggestions(word, this, [=](const QStringList &suggestions) {
+            // Cursor may have moved on, or the word may have been corrected, while
+            // suggestions were looked up.
+            if (m_cursorPosition == position && m_wordUnderCursorIsMisspelled)
+                this->setSpellingSuggestionsForWordUnderCursor(suggestions);
+        });
     } else {
         this->setWordUnderCursorIsMisspelled(false);
         this->setSpellingSuggestionsForWordUnderCursor(QStringList());
@@ -790,7 +801,7 @@ void SpellCheckSyntaxHighlighterDelegate::setSpellingSuggestionsForWordUnderCurs
 }
 
 bool SpellCheckSyntaxHighlighterDelegate::findMisspelledTextFragment(
-        int cursorPosition, TextFragment &misspelledFragment) const
+        int cursorPosition, TextFragment &misspelledFragment, QString *word) const
 {
     QTextCursor cursor(this->document());
     SpellCheckSyntaxHighlighterUserData *ud = nullptr;
@@ -807,6 +818,8 @@ bool SpellCheckSyntaxHighlighterDelegate::findMisspelledTextFragment(
     for (const TextFragment &fragment : mispelledFragments) {
         if (fragment.start() <= blockCursorPosition && fragment.end() >= blockCursorPosition) {
             misspelledFragment = fragment;
+            if (word)
+                *word = block.text().mid(fragment.start(), fragment.length());
             return true;
         }
     }
@@ -353,7 +353,8 @@ private:
     void setWordUnderCursorIsMisspelled(bool val);
     void setSpellingSuggestionsForWordUnderCursor(const QStringList &val);
 
-    bool findMisspelledTextFragment(int cursorPosition, TextFragment &misspelledFragment) const;
+    bool findMisspelledTextFragment(int cursorPosition, TextFragment &misspelledFragment,
+                                    QString *word = nullptr) const;
     bool wordCursor(int cursorPosition, QTextCursor &cursor,
                     SpellCheckSyntaxHighlighterUserData *&ud) const;
 
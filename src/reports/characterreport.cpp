@@ -393,6 +393,8 @@ bool CharacterReport::doGenerate(QTextDocument *textDocument)
         cursor.insertBlock(blockFormat, charFormat);
         cursor.insertText("DETAIL:");
 
+        const Structure *structure = this->document()->structure();
+
         const int nrScenes = screenplay->elementCount();
         for (int i = 0; i < nrScenes; i++) {
             QTextTable *dialogueTable = nullptr;
@@ -402,9 +404,11 @@ bool CharacterReport::doGenerate(QTextDocument *textDocument)
             if (scene == nullptr)
                 continue;
 
+            const SceneCharacterIncidence incidence = structure->characterIncidence(scene);
+
             bool sceneHasSaidCharacters = false;
             for (const QString &characterName : qAsConst(m_characterNames)) {
-                if (scene->characterNames().contains(characterName)) {
+                if (incidence.contains(characterName)) {
                     sceneCount[characterName] = sceneCount.value(characterName, 0) + 1;
 
                     if (sceneInfoWritten == false && m_includeSceneHeadings) {
@@ -438,7 +442,20 @@ bool CharacterReport::doGenerate(QTextDocument *textDocument)
 
             QMap<QString, bool> characterHasDialogue;
 
-            const int nrElements = scene->elementCount();
+            // Without dialogues to write, counting them is all we need and they are cached
+            // already. Otherwise they are counted while being written below.
+            if (!m_includeDialogues) {
+                for (const QString &characterName : qAsConst(m_characterNames)) {
+                    const int nrDialogues = incidence.dialogueCount(characterName);
+                    if (nrDialogues > 0) {
+                        characterHasDialogue[characterName] = true;
+                        dialogCount[characterName] =
+                                dialogCount.value(characterName, 0) + nrDialogues;
+                    }
+                }
+            }
+
+            const int nrElements = m_includeDialogues ? scene->elementCount() : 0;
             for (int j = 0; j < nrElements; j++) {
                 SceneElement *element = scene->elementAt(j);
                 if (element->type() == SceneElement::Character) {
@@ -519,7 +536,7 @@ bool CharacterReport::doGenerate(QTextDocument *textDocument)
             QStringList muteCharacters;
             for (const QString &characterName : qAsConst(m_characterNames)) {
                 if (characterHasDialogue.value(characterName, false) == false
-                    && scene->characterNames().contains(characterName)) {
+                    && incidence.contains(characterName)) {
                     muteCharacters << characterName;
                 }
             }
@@ -48,9 +48,10 @@ bool CharacterScreenplayReport::includeScreenplayElement(const ScreenplayElement
     if (m_characterNames.isEmpty())
         return true;
 
-    const QStringList sceneCharacters = scene->characterNames();
+    const SceneCharacterIncidence incidence =
+            this->document()->structure()->characterIncidence(scene);
     for (const QString &characterName : qAsConst(m_characterNames))
-        if (sceneCharacters.contains(characterName))
+        if (incidence.contains(characterName))
             return true;
 
     return false;
@@ -264,16 +264,23 @@ bool SceneCharacterMatrixReport::doGenerate(QTextDocument *document)
     }
 
     // Mark cells
+    QHash<QString, int> characterIndexes;
+    for (int i = 0; i < m_characterNames.size(); i++)
+        characterIndexes.insert(m_characterNames.at(i), i);
+
+    const Structure *structure = this->document()->structure();
+
     int sceneNumber = 0;
     for (const ScreenplayElement *element : qAsConst(screenplayElements)) {
         const Scene *scene = element->scene();
         if (scene) {
-            const QStringList characters = scene->characterNames();
-            for (const QString &character : characters) {
-                const int row =
-                        m_type == SceneVsCharacter ? sceneNumber : rowHeadings.indexOf(character);
-                const int column = m_type == SceneVsCharacter ? columnHeadings.indexOf(character)
-                                                              : sceneNumber;
+            const SceneCharacterIncidence incidence = structure->characterIncidence(scene);
+            for (auto it = incidence.dialogueCounts.constBegin(),
+                      end = incidence.dialogueCounts.constEnd();
+                 it != end; ++it) {
+                const int characterIndex = characterIndexes.value(it.key(), -1);
+                const int row = m_type == SceneVsCharacter ? sceneNumber : characterIndex;
+                const int column = m_type == SceneVsCharacter ? characterIndex : sceneNumber;
                 if (row < 0 || column < 0)
                     continue;
 
@@ -340,6 +347,12 @@ bool SceneCharacterMatrixReport::directExportToOdf(QIODevice *device)
     ts << "\n";
 
     // Row contents
+    const Structure *structure = this->document()->structure();
+    QVector<SceneCharacterIncidence> incidences;
+    incidences.reserve(screenplayElements.size());
+    for (const ScreenplayElement *element : qAsConst(screenplayElements))
+        incidences.append(structure->characterIncidence(element->scene()));
+
     const QString checkMark = m_marker.isEmpty() ? QStringLiteral("✓") : escapeComma(m_marker);
     for (int i = 0; i < nrRows; i++) {
         if (m_type == SceneVsCharacter) {
@@ -357,18 +370,9 @@ bool SceneCharacterMatrixReport::directExportToOdf(QIODevice *device)
         for (int j = 0; j < nrCols; j++) {
             ts << ",";
 
-            Scene *scene = nullptr;
-            QString characterName;
-
-            if (m_type == SceneVsCharacter) {
-                scene = screenplayElements.at(i)->scene();
-                characterName = m_characterNames.at(j);
-            } else {
-                scene = screenplayElements.at(j)->scene();
-                characterName = m_characterNames.at(i);
-            }
-
-            if (scene->characterNames().contains(characterName))
+            const int sceneIndex = m_type == SceneVsCharacter ? i : j;
+            const int characterIndex = m_type == SceneVsCharacter ? j : i;
+            if (incidences.at(sceneIndex).contains(m_characterNames.at(characterIndex)))
                 ts << checkMark;
         }
 
@@ -20,7 +20,9 @@
 #include "screenplay.h"
 #include "application.h"
 #include "scritedocument.h"
+#include "screenplaylayoutmetrics.h"
 
+#include <QSet>
 #include <QTextTable>
 #include <QScopeGuard>
 #include <QTextCursor>
@@ -134,7 +136,7 @@ QList<StatisticsReport::Distribution> StatisticsReport::textDistribution(bool co
     QList<StatisticsReport::Distribution> ret;
 
     QMap<SceneElement::Type, StatisticsReport::Distribution> map;
-    if (m_textBlockMap.isEmpty() || m_textDocument.isEmpty())
+    if (m_pixelLengths.isEmpty() || qFuzzyIsNull(m_paragraphsLength))
         return ret;
 
     auto add = [&map](SceneElement::Type type, qreal pixelLength) {
@@ -146,8 +148,8 @@ QList<StatisticsReport::Distribution> StatisticsReport::textDistribution(bool co
 
     {
         // First, lets sum up pixel lengths of all paragrap types.
-        auto it = m_textBlockMap.constBegin();
-        auto end = m_textBlockMap.constEnd();
+        auto it = m_pixelLengths.constBegin();
+        auto end = m_pixelLengths.constEnd();
         while (it != end) {
             const QObject *object = it.key();
             const SceneElement *paragraph = qobject_cast<const SceneElement *>(object);
@@ -408,8 +410,8 @@ QList<StatisticsReport::Distribution> StatisticsReport::episodeDistribution() co
 
 bool StatisticsReport::doGenerate(QTextDocument *textDocument)
 {
-    auto guard = qScopeGuard([=]() { this->cleanupTextDocument(); });
-    this->prepareTextDocument();
+    auto guard = qScopeGuard([=]() { this->cleanupLayoutMetrics(); });
+    this->prepareLayoutMetrics();
 
     /**
      * This function is called to generate report into ODT files.
@@ -543,8 +545,8 @@ bool StatisticsReport::usePdfWriter() const
 
 bool StatisticsReport::directPrintToPdf(QPdfWriter *pdfWriter)
 {
-    auto guard = qScopeGuard([=]() { this->cleanupTextDocument(); });
-    this->prepareTextDocument();
+    auto guard = qScopeGuard([=]() { this->cleanupLayoutMetrics(); });
+    this->prepareLayoutMetrics();
 
     const Screenplay *screenplay = this->document()->screenplay();
 
@@ -559,204 +561,112 @@ bool StatisticsReport::directPrintToPdf(QPdfWriter *pdfWriter)
     return ret;
 }
 
-void StatisticsReport::prepareTextDocument()
+void StatisticsReport::prepareLayoutMetrics()
 {
     HourGlass hourGlass;
-    this->cleanupTextDocument();
+    this->cleanupLayoutMetrics();
 
     const Screenplay *screenplay = this->document()->screenplay();
     const ScreenplayFormat *format = this->document()->printFormat();
-    const qreal pageWidth = qCeil(format->pageLayout()->contentWidth());
-    m_pageHeight = qCeil(format->pageLayout()->contentRect().height());
+
+    ScreenplayLayoutMetrics metrics(format);
+    m_pageHeight = metrics.pageHeight();
     m_millisecondsPerPixel = (format->secondsPerPage() * 1000) / m_pageHeight;
 
-    m_textDocument.setUseDesignMetrics(true);
-    m_textDocument.setTextWidth(pageWidth);
-    m_textDocument.setDefaultFont(format->defaultFont());
+    QList<const Scene *> scenes;
+    const int nrElements = screenplay->elementCount();
+    for (int i = 0; i < nrElements; i++) {
+        const ScreenplayElement *element = screenplay->elementAt(i);
+        if (element->scene() != nullptr)
+            scenes.append(element->scene());
+    }
 
-    QTextCursor cursor(&m_textDocument);
-    auto prepareCursor = [=](QTextCursor &cursor, SceneElement::Type paraType,
-                             Qt::Alignment overrideAlignment) {
-        const SceneElementFormat *eformat = format->elementFormat(paraType);
-        QTextBlockFormat blockFormat = eformat->createBlockFormat(overrideAlignment, &pageWidth);
-        QTextCharFormat charFormat = eformat->createCharFormat(&pageWidth);
-        cursor.setCharFormat(charFormat);
-        cursor.setBlockFormat(blockFormat);
-    };
+    // Only paragraphs edited since the last report was generated are laid out here.
+    metrics.prefetch(scenes);
 
-    auto polishFontsAndInsertTextAtCursor = [](QTextCursor &cursor, const QString &text) {
-        TransliterationEngine::instance()->evaluateBoundariesAndInsertText(cursor, text);
+    m_lineHeight = m_pageHeight;
+    auto measure = [&](const QObject *object, qreal length) {
+        m_pixelLengths.insert(object, length);
+        m_paragraphsLength += length;
+        if (length > 0)
+            m_lineHeight = qMin(length, m_lineHeight);
     };
 
-    const int nrElements = screenplay->elementCount();
-    for (int i = 0; i < nrElements; i++) {
-        const ScreenplayElement *element = screenplay->elementAt(i);
-        if (element->scene() == nullptr)
+    QSet<const Scene *> measuredScenes;
+    for (const Scene *scene : qAsConst(scenes)) {
+        if (measuredScenes.contains(scene))
             continue;
 
-        const Scene *scene = element->scene();
-        if (scene->heading()->isEnabled()) {
-            if (cursor.position() > 0)
-                cursor.insertBlock();
-            prepareCursor(cursor, SceneElement::Heading, Qt::Alignment());
-            polishFontsAndInsertTextAtCursor(cursor, scene->heading()->text());
-            m_textBlockMap.insert(scene->heading(), cursor.block());
-        }
+        measuredScenes.insert(scene);
+        if (scene->heading()->isEnabled())
+            measure(scene->heading(), metrics.height(scene->heading()));
 
         for (int p = 0; p < scene->elementCount(); p++) {
-            if (cursor.position() > 0)
-                cursor.insertBlock();
-
             const SceneElement *para = scene->elementAt(p);
-            prepareCursor(cursor, para->type(), para->alignment());
-            polishFontsAndInsertTextAtCursor(cursor, para->text());
-            m_textBlockMap.insert(para, cursor.block());
+            measure(para, metrics.height(para));
         }
     }
 
-    if (m_textDocument.isEmpty() || m_textBlockMap.isEmpty()) {
+    if (qFuzzyIsNull(m_paragraphsLength)) {
         m_paragraphsLength = 0;
         m_lineHeight = 1;
         return;
     }
 
-    QAbstractTextDocumentLayout *layout = m_textDocument.documentLayout();
-    auto it = m_textBlockMap.constBegin();
-    auto end = m_textBlockMap.constEnd();
-    m_lineHeight = m_pageHeight;
-    while (it != end) {
-        const QTextBlock paraBlock = m_textBlockMap.value(it.key());
-        const QRectF paraBlockRect = layout->blockBoundingRect(paraBlock);
-        const qreal paraHeight = paraBlockRect.height();
+    // Scenes are separated by a blank line, which counts towards their length.
+    for (const Scene *scene : qAsConst(scenes)) {
+        qreal sceneLength = 0;
+        if (scene->heading()->isEnabled() || scene->elementCount() > 0)
+            sceneLength = metrics.height(scene) + m_lineHeight;
 
-        m_paragraphsLength += paraHeight;
-        if (paraHeight > 0)
-            m_lineHeight = qMin(paraHeight, m_lineHeight);
-
-        ++it;
-    }
-
-    for (int i = 0; i < nrElements; i++) {
-        const ScreenplayElement *element = screenplay->elementAt(i);
-        if (element->scene() == nullptr)
-            continue;
-
-        const Scene *scene = element->scene();
-        const QObject *para = scene->heading()->isEnabled() ? (QObject *)scene->heading()
-                                                            : (QObject *)scene->elementAt(0);
-        const QTextBlock block = m_textBlockMap.value(para);
-        if (block.isValid()) {
-            QTextCursor cursor(block);
-            cursor.select(QTextCursor::BlockUnderCursor);
-
-            QTextBlockFormat format;
-            format.setTopMargin(block.blockFormat().topMargin() + m_lineHeight);
-            cursor.mergeBlockFormat(format);
-        }
+        m_pixelLengths.insert(scene, sceneLength);
+        m_totalPixelLength += sceneLength;
     }
 }
 
-void StatisticsReport::cleanupTextDocument()
+void StatisticsReport::cleanupLayoutMetrics()
 {
-    m_textBlockMap.clear();
-    m_textDocument.clear();
+    m_pixelLengths.clear();
     m_pageHeight = 0;
+    m_totalPixelLength = 0;
     m_paragraphsLength = 0;
     m_millisecondsPerPixel = 0;
 }
 
 qreal StatisticsReport::pixelLength() const
 {
-    return m_textDocument.isEmpty() ? 0.0 : m_textDocument.size().height();
+    return m_totalPixelLength;
 }
 
 qreal StatisticsReport::pixelLength(const Scene *scene) const
 {
-    return scene ? qMax(this->boundingRect(scene).height(), 0.0) : 0;
+    return m_pixelLengths.value(scene);
 }
 
 qreal StatisticsReport::pixelLength(const SceneHeading *heading) const
 {
-    return qMax(this->boundingRect(heading).height(), 0.0);
+    return m_pixelLengths.value(heading);
 }
 
 qreal StatisticsReport::pixelLength(const SceneElement *para) const
 {
-    return qMax(this->boundingRect(para).height(), 0.0);
+    return m_pixelLengths.value(para);
 }
 
 qreal StatisticsReport::pixelLength(const ScreenplayElement *element) const
 {
-    return qMax(this->boundingRect(element).height(), 0.0);
-}
-
-QRectF StatisticsReport::boundingRect(const Scene *scene) const
-{
-    QRectF nullRect;
-    if (scene == nullptr || m_textDocument.isEmpty() || qFuzzyIsNull(m_pageHeight))
-        return nullRect;
-
-    QTextBlock fromBlock, toBlock;
-
-    if (scene->heading()->isEnabled()) {
-        if (!m_textBlockMap.contains(scene->heading()))
-            return nullRect;
-        fromBlock = m_textBlockMap.value(scene->heading());
-        toBlock = fromBlock;
-    } else {
-        const SceneElement *firstPara = scene->elementAt(0);
-        if (firstPara == nullptr || !m_textBlockMap.contains(firstPara))
-            return nullRect;
-
-        fromBlock = m_textBlockMap.value(firstPara);
-        toBlock = fromBlock;
-    }
-
-    const SceneElement *lastPara = scene->elementAt(scene->elementCount() - 1);
-    if (!lastPara || !m_textBlockMap.contains(lastPara))
-        return nullRect;
-
-    toBlock = m_textBlockMap.value(lastPara);
-
-    QAbstractTextDocumentLayout *layout = m_textDocument.documentLayout();
-    const QRectF fromBlockRect = layout->blockBoundingRect(fromBlock);
-    const QRectF toBlockRect = layout->blockBoundingRect(toBlock);
-    return QRectF(fromBlockRect.topLeft(), toBlockRect.bottomRight() + QPointF(0, m_lineHeight));
-}
-
-QRectF StatisticsReport::boundingRectOfHeadingOrParagraph(const QObject *object) const
-{
-    QRectF nullRect;
-    if (object == nullptr || m_textDocument.isEmpty() || qFuzzyIsNull(m_pageHeight))
-        return nullRect;
-
-    if (!m_textBlockMap.contains(object))
-        return nullRect;
-
-    QAbstractTextDocumentLayout *layout = m_textDocument.documentLayout();
-    const QTextBlock paraBlock = m_textBlockMap.value(object);
-    const QRectF paraBlockRect = layout->blockBoundingRect(paraBlock);
-    return paraBlockRect;
-}
-
-QRectF StatisticsReport::boundingRect(const ScreenplayElement *element) const
-{
-    QRectF nullRect;
     if (element->scene())
-        return this->boundingRect(element->scene());
+        return this->pixelLength(element->scene());
 
     const Screenplay *screenplay = this->document()->screenplay();
     ScreenplayElement *ncelement = const_cast<ScreenplayElement *>(element);
     const QList<int> idxList = screenplay->sceneElementsInBreak(ncelement);
-    if (idxList.isEmpty())
-        return nullRect;
 
-    const QRectF firstRect = this->boundingRect(screenplay->elementAt(idxList.first()));
-    const QRectF lastRect = this->boundingRect(screenplay->elementAt(idxList.last()));
-    if (firstRect.isNull() || lastRect.isNull())
-        return nullRect;
+    qreal ret = 0;
+    for (int idx : idxList)
+        ret += this->pixelLength(screenplay->elementAt(idx));
 
-    return QRectF(firstRect.topLeft(), lastRect.bottomRight() + QPointF(0, m_lineHeight));
+    return ret;
 }
 
 QTime StatisticsReport::pageLengthToTime(qreal val) const
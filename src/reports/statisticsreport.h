@@ -16,6 +16,7 @@
 
 #include <QTime>
 #include <QList>
+#include <QHash>
 #include <QtMath>
 
 #include "abstractreportgenerator.h"
@@ -151,8 +152,8 @@ private:
     friend class StatisticsReportTimeline;
     friend class StatisticsReportKeyNumbers;
 
-    void prepareTextDocument();
-    void cleanupTextDocument();
+    void prepareLayoutMetrics();
+    void cleanupLayoutMetrics();
 
     qreal pageHeight() const { return m_pageHeight; }
 
@@ -202,18 +203,6 @@ private:
     qreal pixelLength(const SceneElement *para) const;
     qreal pixelLength(const ScreenplayElement *element) const;
 
-    QRectF boundingRect(const Scene *scene) const;
-    QRectF boundingRect(const SceneHeading *heading) const
-    {
-        return this->boundingRectOfHeadingOrParagraph(heading);
-    }
-    QRectF boundingRect(const SceneElement *para) const
-    {
-        return this->boundingRectOfHeadingOrParagraph(para);
-    }
-    QRectF boundingRectOfHeadingOrParagraph(const QObject *object) const;
-    QRectF boundingRect(const ScreenplayElement *element) const;
-
     QTime pixelLengthToTime(qreal val) const
     {
         return this->pageLengthToTime(this->pageLength(val));
@@ -223,10 +212,10 @@ private:
     void polish(Distribution &report) const;
 
 private:
-    QTextDocument m_textDocument;
-    QMap<const QObject *, QTextBlock> m_textBlockMap;
+    QHash<const QObject *, qreal> m_pixelLengths; // of scenes, headings and paragraphs
     qreal m_pageHeight = 0;
     qreal m_lineHeight = 0;
+    qreal m_totalPixelLength = 0;
     qreal m_scaleFactor = 1.0;
     int m_maxLocationPresenceGraphs = 6;
     int m_maxCharacterPresenceGraphs = 6;
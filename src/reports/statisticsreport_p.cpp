@@ -924,10 +924,22 @@ StatisticsReportTimeline::evalCharacterPresence(const StatisticsReport *report)
     const QStringList characterNames =
             specificCharacterNames.isEmpty() ? allCharacterNames : specificCharacterNames;
 
+    // evalPresence() asks for one character at a time, scene by scene. So we hold on to the
+    // incidence of the scene being asked about.
+    const Scene *incidenceScene = nullptr;
+    SceneCharacterIncidence incidence;
     QList<QPair<QString, QList<int>>> ret = this->evalPresence(
-            report, characterNames, [](const Scene *scene, const QString &characterName) -> int {
-                return scene->hasCharacter(characterName)
-                        ? scene->characterPresence(characterName) + 2
+            report, characterNames,
+            [structure, &incidenceScene, &incidence](const Scene *scene,
+                                                     const QString &characterName) -> int {
+                if (scene != incidenceScene) {
+                    incidence = structure->characterIncidence(scene);
+                    incidenceScene = scene;
+                }
+
+                // Mute characters have no dialogues, but are present all the same.
+                return incidence.contains(characterName)
+                        ? qMax(incidence.dialogueCount(characterName), 1) + 2
                         : 0;
             });
     if (!specificCharacterNames.isEmpty())
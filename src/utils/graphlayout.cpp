@@ -20,6 +20,9 @@
 #include <QLineF>
 #include <QTransform>
 #include <QElapsedTimer>
+#include <QVarLengthArray>
+
+#include <algorithm>
 
 using namespace GraphLayout;
 
@@ -171,3 +174,503 @@ bool ForceDirectedLayout::placeNodes(const QVector<QPointF> &forces, const Graph
 
     return moved;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+/**
+ * Quadtree over positions of nodes, in which every cell knows the number of nodes in it and
+ * their center of mass. Cells are kept in a flat vector, with the four children of a cell
+ * next to each other.
+ */
+class QuadTree
+{
+public:
+    explicit QuadTree(const QVector<QPointF> &positions);
+    ~QuadTree() { }
+
+    // Sum of (p - position) / |p - position|^2 over positions p of all other nodes, where
+    // cells that are small enough compared to their distance stand in for nodes in them.
+    QPointF repulsion(int node, qreal theta) const;
+
+private:
+    struct Cell
+    {
+        QPointF center;
+        qreal halfSize = 0;
+        QPointF massCenter;
+        int mass = 0;
+        int node = -1; // of a leaf cell with one node in it
+        int firstChild = -1;
+
+        bool contains(const QPointF &pos) const
+        {
+            return qAbs(pos.x() - center.x()) <= halfSize
+                    && qAbs(pos.y() - center.y()) <= halfSize;
+        }
+        int childFor(const QPointF &pos) const
+        {
+            return (pos.x() >= center.x() ? 1 : 0) | (pos.y() >= center.y() ? 2 : 0);
+        }
+    };
+
+    void insert(int node);
+    void subdivide(int cellIndex);
+
+private:
+    // Nodes at (nearly) the same position would otherwise subdivide cells forever.
+    enum { MaxDepth = 40 };
+
+    const QVector<QPointF> &m_positions;
+    QVector<Cell> m_cells;
+};
+
+QuadTree::QuadTree(const QVector<QPointF> &positions) : m_positions(positions)
+{
+    if (positions.isEmpty())
+        return;
+
+    qreal left = positions.first().x(), right = left;
+    qreal top = positions.first().y(), bottom = top;
+    for (const QPointF &pos : positions) {
+        left = qMin(left, pos.x());
+        right = qMax(right, pos.x());
+        top = qMin(top, pos.y());
+        bottom = qMax(bottom, pos.y());
+    }
+
+    Cell root;
+    root.center = QPointF((left + right) / 2, (top + bottom) / 2);
+    root.halfSize = qMax(qMax(right - left, bottom - top) / 2, 1e-6);
+
+    m_cells.reserve(positions.size() * 4);
+    m_cells.append(root);
+
+    for (int i = 0; i < positions.size(); i++)
+        this->insert(i);
+}
+
+QPointF QuadTree::repulsion(int node, qreal theta) const
+{
+    QPointF ret(0, 0);
+    if (m_cells.isEmpty())
+        return ret;
+
+    const QPointF pos = m_positions.at(node);
+    const qreal theta2 = theta * theta;
+
+    QVarLengthArray<int, 128> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Cell &cell = m_cells.at(stack.last());
+        stack.removeLast();
+
+        if (cell.mass == 0 || cell.node == node)
+            continue;
+
+        const QPointF dp = cell.massCenter - pos;
+        const qreal distance2 = dp.x() * dp.x() + dp.y() * dp.y();
+        const qreal size = cell.halfSize * 2;
+
+        const bool farEnough = !cell.contains(pos) && size * size < theta2 * distance2;
+        if (cell.firstChild < 0 || farEnough) {
+            if (!qFuzzyIsNull(distance2))
+                ret += dp * (cell.mass / distance2);
+            continue;
+        }
+
+        for (int i = 0; i < 4; i++)
+            stack.append(cell.firstChild + i);
+    }
+
+    return ret;
+}
+
+void QuadTree::insert(int node)
+{
+    const QPointF pos = m_positions.at(node);
+
+    int cellIndex = 0;
+    for (int depth = 0;; depth++) {
+        Cell &cell = m_cells[cellIndex];
+        if (cell.firstChild < 0) {
+            if (cell.mass == 0 || depth >= MaxDepth) {
+                cell.massCenter = (cell.massCenter * cell.mass + pos) / (cell.mass + 1);
+                cell.node = cell.mass == 0 ? node : -1;
+                ++cell.mass;
+                return;
+            }
+
+            this->subdivide(cellIndex);
+        }
+
+        Cell &parent = m_cells[cellIndex];
+        parent.massCenter = (parent.massCenter * parent.mass + pos) / (parent.mass + 1);
+        ++parent.mass;
+        cellIndex = parent.firstChild + parent.childFor(pos);
+    }
+}
+
+void QuadTree::subdivide(int cellIndex)
+{
+    const Cell cell = m_cells.at(cellIndex);
+    const int firstChild = m_cells.size();
+
+    for (int i = 0; i < 4; i++) {
+        Cell child;
+        child.halfSize = cell.halfSize / 2;
+        child.center = cell.center
+                + QPointF(i & 1 ? child.halfSize : -child.halfSize,
+                          i & 2 ? child.halfSize : -child.halfSize);
+        m_cells.append(child);
+    }
+
+    // Leaf cells that are subdivided have exactly one node, which moves into a child.
+    Cell &child = m_cells[firstChild + cell.childFor(cell.massCenter)];
+    child.node = cell.node;
+    child.mass = cell.mass;
+    child.massCenter = cell.massCenter;
+
+    m_cells[cellIndex].node = -1;
+    m_cells[cellIndex].firstChild = firstChild;
+}
+
+}
+
+BarnesHutLayout::BarnesHutLayout() { }
+
+BarnesHutLayout::~BarnesHutLayout() { }
+
+bool BarnesHutLayout::layout(const Graph &graph)
+{
+    // Same sanity checks as ForceDirectedLayout, except that edges are resolved into
+    // indexes of their nodes just once.
+    if (graph.nodes.isEmpty() || graph.edges.isEmpty())
+        return false;
+
+    const int nrNodes = graph.nodes.size();
+
+    QHash<AbstractNode *, int> nodeIndexMap;
+    nodeIndexMap.reserve(nrNodes);
+    for (int i = 0; i < nrNodes; i++)
+        nodeIndexMap.insert(graph.nodes.at(i), i);
+
+    QVector<int> refCounts(nrNodes, 0);
+    QVector<QPair<int, int>> edges;
+    edges.reserve(graph.edges.size());
+    for (AbstractEdge *edge : qAsConst(graph.edges)) {
+        const int i1 = nodeIndexMap.value(edge->node1(), -1);
+        const int i2 = nodeIndexMap.value(edge->node2(), -1);
+        if (i1 < 0 || i2 < 0)
+            return false;
+        edges.append(qMakePair(i1, i2));
+        refCounts[i1]++;
+        refCounts[i2]++;
+    }
+
+    if (refCounts.contains(0))
+        return false;
+
+    // Place the nodes in a circle and figure out maximum size of nodes. Nodes are moved
+    // around in this vector of positions, and placed only once they are all laid out.
+    const qreal angleStep = 2 * M_PI / qreal(nrNodes);
+    QVector<QPointF> positions(nrNodes);
+    QSizeF maxSize(0, 0);
+    for (int i = 0; i < nrNodes; i++) {
+        const AbstractNode *node = graph.nodes.at(i);
+        const qreal angle = i * angleStep;
+        positions[i] = node->canBeMoved() ? QPointF(qCos(angle), qSin(angle)) : node->position();
+
+        const QSizeF nodeSize = node->size();
+        maxSize.setWidth(qMax(nodeSize.width(), maxSize.width()));
+        maxSize.setHeight(qMax(nodeSize.height(), maxSize.height()));
+    }
+
+    // Perform force directed graph layout
+    int nrIterations = 0;
+    QVector<QPointF> forces(nrNodes);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (timer.elapsed() < this->maxTime()) {
+        forces.fill(QPointF(0, 0));
+        this->calculateRepulsion(forces, positions);
+        this->calculateAttraction(forces, positions, edges);
+        const bool moved = this->placeNodes(forces, positions);
+
+        ++nrIterations;
+        if (!moved || (maxIterations() > 0 && nrIterations >= maxIterations()))
+            break;
+    }
+
+    // Scale the placement of nodes such that the closest two nodes are far enough apart
+    // for nodes and labels of edges between them.
+    const qreal minNodeSpacingPx = this->minimumEdgeLength()
+            + QLineF(QPointF(0, 0), QPointF(maxSize.width(), maxSize.height())).length();
+    const qreal minNodeSpacing = this->minimumNodeSpacing(positions);
+    const qreal scale = qFuzzyIsNull(minNodeSpacing) ? 1.0 : minNodeSpacingPx / minNodeSpacing;
+
+    for (int i = 0; i < nrNodes; i++)
+        graph.nodes.at(i)->setPosition(positions.at(i) * scale);
+
+    // Get the edges to compute their paths
+    for (AbstractEdge *edge : qAsConst(graph.edges))
+        edge->evaluateEdge();
+
+    return true;
+}
+
+void BarnesHutLayout::calculateRepulsion(QVector<QPointF> &forces,
+                                         const QVector<QPointF> &positions) const
+{
+    // Force of k / d, along the unit vector dp / d, is k * dp / d^2.
+    const qreal k = fdg_constant;
+    const QuadTree tree(positions);
+    for (int i = 0; i < positions.size(); i++)
+        forces[i] -= tree.repulsion(i, m_theta) * k;
+}
+
+void BarnesHutLayout::calculateAttraction(QVector<QPointF> &forces,
+                                          const QVector<QPointF> &positions,
+                                          const QVector<QPair<int, int>> &edges) const
+{
+    // Force of k * d^2, along the unit vector dp / d, is k * d * dp.
+    const qreal k = fdg_constant;
+    for (const QPair<int, int> &edge : edges) {
+        const QPointF dp = positions.at(edge.second) - positions.at(edge.first);
+        const QPointF delta = dp * (k * qSqrt(dp.x() * dp.x() + dp.y() * dp.y()));
+        forces[edge.first] += delta;
+        forces[edge.second] -= delta;
+    }
+}
+
+bool BarnesHutLayout::placeNodes(const QVector<QPointF> &forces,
+                                 QVector<QPointF> &positions) const
+{
+    bool moved = false;
+    for (int i = 0; i < positions.size(); i++) {
+        const QPointF force = forces.at(i);
+        if (qFuzzyIsNull(force.x()) && qFuzzyIsNull(force.y()))
+            continue;
+
+        positions[i] += force;
+        moved = true;
+    }
+
+    return moved;
+}
+
+qreal BarnesHutLayout::minimumNodeSpacing(const QVector<QPointF> &positions) const
+{
+    // Sweep across nodes sorted by x, comparing each node only with those to its right
+    // that are closer along x than the least spacing found so far.
+    QVector<QPointF> sortedPositions = positions;
+    std::sort(sortedPositions.begin(), sortedPositions.end(),
+              [](const QPointF &a, const QPointF &b) { return a.x() < b.x(); });
+
+    qreal ret = 240000.0;
+    for (int i = 0; i < sortedPositions.size(); i++) {
+        const QPointF &p1 = sortedPositions.at(i);
+        for (int j = i + 1; j < sortedPositions.size(); j++) {
+            const QPointF &p2 = sortedPositions.at(j);
+            if (p2.x() - p1.x() >= ret)
+                break;
+
+            ret = qMin(ret, QLineF(p1, p2).length());
+        }
+    }
+
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+IncrementalLayout::IncrementalLayout() { }
+
+IncrementalLayout::~IncrementalLayout() { }
+
+bool IncrementalLayout::snapshot(const Graph &graph, Snapshot &snapshot) const
+{
+    snapshot = Snapshot();
+    if (graph.nodes.isEmpty() || graph.edges.isEmpty())
+        return false;
+
+    const int nrNodes = graph.nodes.size();
+
+    QHash<AbstractNode *, int> nodeIndexMap;
+    nodeIndexMap.reserve(nrNodes);
+    for (int i = 0; i < nrNodes; i++)
+        nodeIndexMap.insert(graph.nodes.at(i), i);
+
+    snapshot.edges.reserve(graph.edges.size());
+    for (AbstractEdge *edge : qAsConst(graph.edges)) {
+        const int i1 = nodeIndexMap.value(edge->node1(), -1);
+        const int i2 = nodeIndexMap.value(edge->node2(), -1);
+        if (i1 < 0 || i2 < 0)
+            return false;
+        snapshot.edges.append(qMakePair(i1, i2));
+    }
+
+    QSizeF maxSize(0, 0);
+    snapshot.positions.reserve(nrNodes);
+    snapshot.movable.reserve(nrNodes);
+    for (const AbstractNode *node : qAsConst(graph.nodes)) {
+        snapshot.positions.append(node->position());
+        snapshot.movable.append(node->canBeMoved());
+
+        const QSizeF nodeSize = node->size();
+        maxSize.setWidth(qMax(nodeSize.width(), maxSize.width()));
+        maxSize.setHeight(qMax(nodeSize.height(), maxSize.height()));
+    }
+
+    // Same spacing that other layouts scale their graphs to.
+    snapshot.idealEdgeLength = this->minimumEdgeLength()
+            + QLineF(QPointF(0, 0), QPointF(maxSize.width(), maxSize.height())).length();
+
+    return snapshot.movable.contains(true);
+}
+
+void IncrementalLayout::seed(Snapshot &snapshot) const
+{
+    // Movable nodes start out an edge length away from the average position of their
+    // neighbours that are placed already. Nodes whose neighbours aren't placed yet wait
+    // for them, and nodes with no placed neighbours at all start out around the centroid
+    // of nodes that cannot be moved. Successive nodes are placed at golden angles from
+    // each other, so that they don't start on top of one another.
+    const int nrNodes = snapshot.positions.size();
+
+    QVector<QVector<int>> neighbours(nrNodes);
+    for (const QPair<int, int> &edge : qAsConst(snapshot.edges)) {
+        neighbours[edge.first].append(edge.second);
+        neighbours[edge.second].append(edge.first);
+    }
+
+    QVector<bool> placed(nrNodes);
+    QPointF centroid(0, 0);
+    int nrPinnedNodes = 0;
+    for (int i = 0; i < nrNodes; i++) {
+        placed[i] = !snapshot.movable.at(i);
+        if (placed.at(i)) {
+            centroid += snapshot.positions.at(i);
+            ++nrPinnedNodes;
+        }
+    }
+    if (nrPinnedNodes > 0)
+        centroid /= nrPinnedNodes;
+
+    const qreal goldenAngle = M_PI * (3.0 - qSqrt(5.0));
+    int nrSeededNodes = 0;
+    auto place = [&](int i, const QPointF &around) {
+        const qreal angle = goldenAngle * nrSeededNodes++;
+        snapshot.positions[i] =
+                around + QPointF(qCos(angle), qSin(angle)) * snapshot.idealEdgeLength;
+        placed[i] = true;
+    };
+
+    for (bool progress = true; progress;) {
+        progress = false;
+        for (int i = 0; i < nrNodes; i++) {
+            if (placed.at(i))
+                continue;
+
+            QPointF sum(0, 0);
+            int count = 0;
+            for (int j : qAsConst(neighbours.at(i))) {
+                if (placed.at(j)) {
+                    sum += snapshot.positions.at(j);
+                    ++count;
+                }
+            }
+
+            if (count > 0) {
+                place(i, sum / count);
+                progress = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < nrNodes; i++) {
+        if (!placed.at(i))
+            place(i, centroid);
+    }
+}
+
+void IncrementalLayout::layout(Snapshot &snapshot) const
+{
+    const int nrNodes = snapshot.positions.size();
+    const int nrIterations = this->maxIterations() > 0 ? this->maxIterations() : 60;
+    const qreal length = qMax(snapshot.idealEdgeLength, 1.0);
+    const qreal theta = 0.5;
+
+    QVector<QPointF> forces(nrNodes);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int iteration = 0; iteration < nrIterations && timer.elapsed() < this->maxTime();
+         iteration++) {
+        forces.fill(QPointF(0, 0));
+
+        // Repulsion of L^2 / d, along the unit vector dp / d, is L^2 * dp / d^2.
+        {
+            const QuadTree tree(snapshot.positions);
+            for (int i = 0; i < nrNodes; i++) {
+                if (snapshot.movable.at(i))
+                    forces[i] -= tree.repulsion(i, theta) * (length * length);
+            }
+        }
+
+        // Attraction of d^2 / L, along the unit vector dp / d, is d * dp / L.
+        for (const QPair<int, int> &edge : qAsConst(snapshot.edges)) {
+            const QPointF dp =
+                    snapshot.positions.at(edge.second) - snapshot.positions.at(edge.first);
+            const QPointF delta = dp * (qSqrt(dp.x() * dp.x() + dp.y() * dp.y()) / length);
+            forces[edge.first] += delta;
+            forces[edge.second] -= delta;
+        }
+
+        // Nodes move by up to an edge length in the first iteration, and hardly at all in
+        // the last one.
+        const qreal temperature = length * (1.0 - qreal(iteration) / nrIterations);
+
+        bool moved = false;
+        for (int i = 0; i < nrNodes; i++) {
+            if (!snapshot.movable.at(i))
+                continue;
+
+            const QPointF force = forces.at(i);
+            const qreal magnitude = qSqrt(force.x() * force.x() + force.y() * force.y());
+            if (qFuzzyIsNull(magnitude))
+                continue;
+
+            snapshot.positions[i] += force * (qMin(magnitude, temperature) / magnitude);
+            moved = true;
+        }
+
+        if (!moved)
+            break;
+    }
+}
+
+bool IncrementalLayout::layout(const Graph &graph)
+{
+    Snapshot snapshot;
+    if (!this->snapshot(graph, snapshot))
+        return false;
+
+    this->seed(snapshot);
+    this->layout(snapshot);
+
+    for (int i = 0; i < graph.nodes.size(); i++) {
+        if (snapshot.movable.at(i))
+            graph.nodes.at(i)->setPosition(snapshot.positions.at(i));
+    }
+
+    // Get the edges to compute their paths
+    for (AbstractEdge *edge : qAsConst(graph.edges))
+        edge->evaluateEdge();
+
+    return true;
+}
@@ -16,6 +16,7 @@
 
 #include <QSizeF>
 #include <QPointF>
+#include <QPair>
 #include <QVector>
 #include <QVector2D>
 
@@ -66,6 +67,8 @@ struct Graph
 class AbstractLayout
 {
 public:
+    virtual ~AbstractLayout() { }
+
     void setMaxTime(qint32 time) { m_maxtime = time; }
     qint32 maxTime() const { return m_maxtime; }
 
@@ -99,6 +102,66 @@ private:
     bool placeNodes(const QVector<QPointF> &forces, const Graph &graph);
 };
 
+// Lays out graphs with the same forces as ForceDirectedLayout, but approximates repulsion
+// between nodes with a quadtree, which takes O(n log n) time per iteration instead of O(n^2).
+// https://en.wikipedia.org/wiki/Barnes%E2%80%93Hut_simulation
+class BarnesHutLayout : public AbstractLayout
+{
+public:
+    explicit BarnesHutLayout();
+    ~BarnesHutLayout();
+
+    // Nodes in a quadtree cell whose size is less than theta times its distance from a
+    // node repel the node as one. Zero computes repulsion between every pair of nodes.
+    void setTheta(qreal val) { m_theta = qMax(val, 0.0); }
+    qreal theta() const { return m_theta; }
+
+    // AbstractGraphLayout interface
+    bool layout(const Graph &graph);
+
+private:
+    void calculateRepulsion(QVector<QPointF> &forces, const QVector<QPointF> &positions) const;
+    void calculateAttraction(QVector<QPointF> &forces, const QVector<QPointF> &positions,
+                             const QVector<QPair<int, int>> &edges) const;
+    bool placeNodes(const QVector<QPointF> &forces, QVector<QPointF> &positions) const;
+    qreal minimumNodeSpacing(const QVector<QPointF> &positions) const;
+
+private:
+    qreal m_theta = 0.5;
+};
+
+// Lays out nodes that can be moved starting from where they already are, while nodes that
+// cannot be moved stay put. Graphs to which nodes were added change no more than they have to.
+// Forces are those of Fruchterman and Reingold, in the same units as positions of nodes, with
+// edges pulling their nodes towards being the minimum node spacing apart. Nodes move less with
+// every iteration, of which there are 60 unless maxIterations() is set.
+//
+// snapshot() captures the graph and seed() places new nodes next to their neighbours. Both
+// must be called from the thread that owns the nodes. layout(Snapshot &) works only on the
+// snapshot, and may be called from any thread.
+class IncrementalLayout : public AbstractLayout
+{
+public:
+    struct Snapshot
+    {
+        QVector<QPointF> positions;
+        QVector<bool> movable;
+        QVector<QPair<int, int>> edges;
+        qreal idealEdgeLength = 0;
+    };
+
+    explicit IncrementalLayout();
+    ~IncrementalLayout();
+
+    // Returns false if the graph cannot be laid out, or has no nodes that can be moved.
+    bool snapshot(const Graph &graph, Snapshot &snapshot) const;
+    void seed(Snapshot &snapshot) const;
+    void layout(Snapshot &snapshot) const;
+
+    // AbstractGraphLayout interface
+    bool layout(const Graph &graph);
+};
+
 }
 
 #endif // GRAPHLAYOUT_H
@@ -15,13 +15,17 @@
 #include "timeprofiler.h"
 
 #include <QtDebug>
+#include <QHash>
+#include <QMutex>
 #include <QStack>
+#include <QVector>
 #include <QColor>
 #include <QMetaType>
 #include <QMetaEnum>
 #include <QMetaObject>
 #include <QMetaProperty>
 #include <QMetaClassInfo>
+#include <QSharedPointer>
 #include <QJsonDocument>
 #include <QQmlListProperty>
 #include <QQmlListReference>
@@ -138,65 +142,123 @@ const QObjectSerializer::Helper *ObjectSerializerHelperRegistry::findHelper(int
 
 Q_GLOBAL_STATIC(ObjectSerializerHelperRegistry, Helpers)
 
-void QObjectSerializer::registerHelper(QObjectSerializer::Helper *helper)
+/**
+ * Serialization plan of a class. Walking up the QMetaObject hierarchy, leaving out properties
+ * that are never serialized, classifying the rest and looking up their helpers and default
+ * values happens only once per class. toJson() and fromJson() simply iterate over properties
+ * in the plan, base class properties first.
+ */
+struct SerializationPlan
 {
-    if (::Helpers()->contains(helper))
-        return;
+    enum PropertyKind { ListProperty, EnumProperty, ObjectProperty, ValueProperty };
+
+    struct Property
+    {
+        const QMetaObject *metaObject = nullptr; // class that declares the property
+        QMetaProperty property;
+        PropertyKind kind = ValueProperty;
+        const QObjectSerializer::Helper *helper = nullptr;
+        QString key;
+        QVariant defaultValue;
+    };
 
-    ::Helpers()->append(helper);
-}
+    QVector<Property> properties;
+};
 
-QObjectSerializer::Helper::~Helper()
+typedef QSharedPointer<const SerializationPlan> SerializationPlanPtr;
+
+class SerializationPlans
 {
-    ::Helpers()->removeOne(this);
-}
+public:
+    SerializationPlanPtr plan(const QMetaObject *mo);
+    void clear();
 
-QObjectSerializer::Interface::~Interface() { }
+    bool hasDefaultPropertyValues(const QByteArray &className) const;
+    QVariantMap defaultPropertyValues(const QByteArray &className) const;
+    void setDefaultPropertyValues(const QByteArray &className, const QVariantMap &values);
 
-QJsonObject QObjectSerializer::toJson(const QObject *object)
+private:
+    SerializationPlan *createPlan(const QMetaObject *mo) const;
+
+private:
+    mutable QMutex m_mutex;
+    QHash<const QMetaObject *, SerializationPlanPtr> m_plans;
+    QHash<QByteArray, QVariantMap> m_defaultPropertyValues;
+};
+
+Q_GLOBAL_STATIC(SerializationPlans, ThePlans)
+
+SerializationPlanPtr SerializationPlans::plan(const QMetaObject *mo)
 {
-    QJsonObject ret;
-    if (object == nullptr)
-        return ret;
+    QMutexLocker locker(&m_mutex);
 
-    QObjectSerializer::Interface *interface = qobject_cast<QObjectSerializer::Interface *>(object);
-    if (interface != nullptr)
-        interface->prepareForSerialization();
+    SerializationPlanPtr ret = m_plans.value(mo);
+    if (ret.isNull()) {
+        ret = SerializationPlanPtr(this->createPlan(mo));
+        m_plans.insert(mo, ret);
+    }
 
-    QStack<const QMetaObject *> metaObjects;
-    QStringList classNames;
-    const QMetaObject *mo = object->metaObject();
-    while (mo) {
-        metaObjects.push(mo);
-        if (interface != nullptr && interface->canSerialize(mo, QMetaProperty()) == false) {
-            mo = mo->superClass();
-            continue;
-        }
+    return ret;
+}
 
-        classNames << QString::fromLatin1(mo->className());
-        mo = mo->superClass();
+void SerializationPlans::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_plans.clear();
+}
+
+bool SerializationPlans::hasDefaultPropertyValues(const QByteArray &className) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_defaultPropertyValues.contains(className);
+}
+
+QVariantMap SerializationPlans::defaultPropertyValues(const QByteArray &className) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_defaultPropertyValues.value(className);
+}
+
+void SerializationPlans::setDefaultPropertyValues(const QByteArray &className,
+                                                  const QVariantMap &values)
+{
+    QMutexLocker locker(&m_mutex);
+    m_defaultPropertyValues.insert(className, values);
+
+    // Plans capture default values, so the plan for this class must be created afresh.
+    for (auto it = m_plans.begin(); it != m_plans.end();) {
+        if (className == it.key()->className())
+            it = m_plans.erase(it);
+        else
+            ++it;
     }
+}
 
-    // ret.insert("_class", classNames.join(","));
+SerializationPlan *SerializationPlans::createPlan(const QMetaObject *mo) const
+{
+    SerializationPlan *ret = new SerializationPlan;
+
+    QStack<const QMetaObject *> metaObjects;
+    for (const QMetaObject *it = mo; it != nullptr; it = it->superClass())
+        metaObjects.push(it);
 
     const QVariantMap defaultProperties =
-            QObjectSerializer::cacheDefaultPropertyValues(object, true);
+            m_defaultPropertyValues.value(QByteArray(mo->className()));
 
     while (!metaObjects.isEmpty()) {
-        mo = metaObjects.pop();
+        const QMetaObject *propMo = metaObjects.pop();
 
-        const int nrProperties = mo->propertyCount();
-        for (int i = mo->propertyOffset(); i < nrProperties; i++) {
-            const QMetaProperty prop = mo->property(i);
-            if (interface != nullptr && interface->canSerialize(mo, prop) == false)
-                continue;
+        const int nrProperties = propMo->propertyCount();
+        for (int i = propMo->propertyOffset(); i < nrProperties; i++) {
+            const QMetaProperty prop = propMo->property(i);
 
 #ifdef QT_WIDGETS_LIB
             // QGraphicsObject::parent property returns a parent QGraphicsObject.
             // While saving a QGraphicsObject, we could end up in recursion if
             // we are saving the QGraphicsObject's children also.
             static const char *parentPropName = "parent";
-            if (mo == &QGraphicsObject::staticMetaObject && !qstrcmp(prop.name(), parentPropName))
+            if (propMo == &QGraphicsObject::staticMetaObject
+                && !qstrcmp(prop.name(), parentPropName))
                 continue;
 #endif
 
@@ -225,50 +287,179 @@ QJsonObject QObjectSerializer::toJson(const QObject *object)
             if (!prop.isWritable() && !isQObjectPointer && !isQQmlListProperty)
                 continue;
 
-            const QString propName = QString::fromLatin1(prop.name());
-            const QVariant defaultPropValue = defaultProperties.value(propName);
-            QVariant propValue = prop.read(object);
+            SerializationPlan::Property planProp;
+            planProp.metaObject = propMo;
+            planProp.property = prop;
+            planProp.key = QString::fromLatin1(prop.name());
+            planProp.defaultValue = defaultProperties.value(planProp.key);
+
+            // Flags are also enum types, as far as QMetaProperty is concerned.
+            if (isQQmlListProperty)
+                planProp.kind = SerializationPlan::ListProperty;
+            else if (prop.isEnumType())
+                planProp.kind = SerializationPlan::EnumProperty;
+            else if (isQObjectPointer)
+                planProp.kind = SerializationPlan::ObjectProperty;
+            else {
+                planProp.kind = SerializationPlan::ValueProperty;
+                planProp.helper = ::Helpers()->findHelper(prop.userType());
+            }
 
-            if (isQQmlListProperty) {
-                QJsonArray list;
+            ret->properties.append(planProp);
+        }
+    }
 
-                QQmlListReference listRef(const_cast<QObject *>(object), prop.name());
-                for (int i = 0; i < listRef.count(); i++) {
-                    const QObject *listItem = listRef.at(i);
-                    if (listItem == nullptr)
-                        continue;
+    return ret;
+}
 
-                    QJsonObject item = QObjectSerializer::toJson(listItem);
-                    list.append(item);
-                }
+void QObjectSerializer::registerHelper(QObjectSerializer::Helper *helper)
+{
+    if (::Helpers()->contains(helper))
+        return;
 
-                ret.insert(propName, list);
-            } else if (prop.isEnumType()) {
-                const QMetaEnum propEnum = prop.enumerator();
-                propValue = QString::fromLatin1(propEnum.valueToKey(propValue.toInt()));
-                if (defaultPropValue == propValue.toString())
-                    continue;
+    ::Helpers()->append(helper);
 
-                ret.insert(propName, propValue.toString());
-            } else if (prop.isFlagType()) {
-                const QMetaEnum propEnum = prop.enumerator();
-                propValue = QString::fromLatin1(propEnum.valueToKeys(propValue.toInt()));
-                if (defaultPropValue == propValue.toString())
+    // Plans capture helpers of value properties, so they must be created afresh.
+    ::ThePlans()->clear();
+}
+
+QObjectSerializer::Helper::~Helper()
+{
+    ::Helpers()->removeOne(this);
+
+    if (!::ThePlans.isDestroyed())
+        ::ThePlans()->clear();
+}
+
+QObjectSerializer::Interface::~Interface() { }
+
+/**
+ * JSON produced by toJson() for objects that offer a serialization cache key, along with
+ * the modification time of the object at that point. Entries are dropped when objects
+ * are destroyed, so that a new object allocated at the same address never picks up JSON
+ * of an old one.
+ */
+class SerializationCache
+{
+public:
+    bool lookup(const QObject *object, int modificationTime, QJsonObject &json) const
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_entries.constFind(object);
+        if (it == m_entries.constEnd() || it->modificationTime != modificationTime)
+            return false;
+        json = it->json;
+        return true;
+    }
+
+    void store(const QObject *object, int modificationTime, const QJsonObject &json)
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(object);
+        if (it == m_entries.end()) {
+            it = m_entries.insert(object, Entry());
+            QObject::connect(object, &QObject::destroyed, &SerializationCache::onObjectDestroyed);
+        }
+        it->modificationTime = modificationTime;
+        it->json = json;
+    }
+
+    void remove(const QObject *object)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_entries.remove(object);
+    }
+
+    static void onObjectDestroyed(QObject *object);
+
+private:
+    struct Entry
+    {
+        int modificationTime = -1;
+        QJsonObject json;
+    };
+    mutable QMutex m_mutex;
+    QHash<const QObject *, Entry> m_entries;
+};
+
+Q_GLOBAL_STATIC(SerializationCache, TheSerializationCache)
+
+void SerializationCache::onObjectDestroyed(QObject *object)
+{
+    if (!::TheSerializationCache.isDestroyed())
+        ::TheSerializationCache()->remove(object);
+}
+
+QJsonObject QObjectSerializer::toJson(const QObject *object)
+{
+    QJsonObject ret;
+    if (object == nullptr)
+        return ret;
+
+    QObjectSerializer::Interface *interface = qobject_cast<QObjectSerializer::Interface *>(object);
+
+    const Modifiable *cacheKey = interface ? interface->serializationCacheKey() : nullptr;
+    if (cacheKey != nullptr
+        && ::TheSerializationCache()->lookup(object, cacheKey->modificationTime(), ret))
+        return ret;
+
+    if (interface != nullptr)
+        interface->prepareForSerialization();
+
+    const SerializationPlanPtr plan = ::ThePlans()->plan(object->metaObject());
+
+    for (const SerializationPlan::Property &planProp : plan->properties) {
+        const QMetaProperty &prop = planProp.property;
+        if (interface != nullptr && interface->canSerialize(planProp.metaObject, prop) == false)
+            continue;
+
+        const QString &propName = planProp.key;
+        const QVariant &defaultPropValue = planProp.defaultValue;
+
+        switch (planProp.kind) {
+        case SerializationPlan::ListProperty: {
+            QJsonArray list;
+
+            QQmlListReference listRef(const_cast<QObject *>(object), prop.name());
+            const int nrItems = listRef.count();
+            for (int i = 0; i < nrItems; i++) {
+                const QObject *listItem = listRef.at(i);
+                if (listItem == nullptr)
                     continue;
 
-                ret.insert(propName, propValue.toString());
-            } else if (propType.flags() & QMetaType::PointerToQObject) {
-                propValue.convert(QMetaType::QObjectStar);
+                QJsonObject item = QObjectSerializer::toJson(listItem);
+                list.append(item);
+            }
 
-                const QObject *propObject = propValue.value<QObject *>();
-                if (propObject != nullptr) {
-                    const QJsonObject propJson = QObjectSerializer::toJson(propObject);
-                    if (!propJson.isEmpty())
-                        ret.insert(propName, propJson);
-                }
-            } else if (propValue.userType() == QMetaType::QJsonValue) {
+            ret.insert(propName, list);
+        } break;
+        case SerializationPlan::EnumProperty: {
+            const QMetaEnum propEnum = prop.enumerator();
+            const QString propValue =
+                    QString::fromLatin1(propEnum.valueToKey(prop.read(object).toInt()));
+            if (defaultPropValue == propValue)
+                continue;
+
+            ret.insert(propName, propValue);
+        } break;
+        case SerializationPlan::ObjectProperty: {
+            QVariant propValue = prop.read(object);
+            propValue.convert(QMetaType::QObjectStar);
+
+            const QObject *propObject = propValue.value<QObject *>();
+            if (propObject != nullptr) {
+                const QJsonObject propJson = QObjectSerializer::toJson(propObject);
+                if (!propJson.isEmpty())
+                    ret.insert(propName, propJson);
+            }
+        } break;
+        case SerializationPlan::ValueProperty: {
+            // Properties of type QVariant can hold JSON values, so we have to look at
+            // the type of the value here, not the type of the property.
+            const QVariant propValue = prop.read(object);
+            if (propValue.userType() == QMetaType::QJsonValue) {
                 const QJsonValue propJsonValue = propValue.toJsonValue();
-                if (defaultPropValue.toJsonValue() == propValue.toJsonValue())
+                if (defaultPropValue.toJsonValue() == propJsonValue)
                     continue;
 
                 ret.insert(propName, propJsonValue);
@@ -284,21 +475,19 @@ QJsonObject QObjectSerializer::toJson(const QObject *object)
                     continue;
 
                 ret.insert(propName, propJsonArray);
-            } else {
-                const QObjectSerializer::Helper *helper = ::Helpers()->findHelper(prop.userType());
-                if (helper == nullptr) {
-                    if (propValue == defaultPropValue)
-                        continue;
+            } else if (planProp.helper == nullptr) {
+                if (propValue == defaultPropValue)
+                    continue;
 
-                    ret.insert(propName, QJsonValue::fromVariant(propValue));
-                } else {
-                    const QJsonValue propJsonValue = helper->toJson(propValue);
-                    if (propJsonValue == defaultPropValue.toJsonValue())
-                        continue;
+                ret.insert(propName, QJsonValue::fromVariant(propValue));
+            } else {
+                const QJsonValue propJsonValue = planProp.helper->toJson(propValue);
+                if (propJsonValue == defaultPropValue.toJsonValue())
+                    continue;
 
-                    ret.insert(propName, propJsonValue);
-                }
+                ret.insert(propName, propJsonValue);
             }
+        } break;
         }
     }
 
@@ -315,6 +504,9 @@ QJsonObject QObjectSerializer::toJson(const QObject *object)
     if (interface != nullptr)
         interface->serializeToJson(ret);
 
+    if (cacheKey != nullptr)
+        ::TheSerializationCache()->store(object, cacheKey->modificationTime(), ret);
+
     return ret;
 }
 
@@ -330,132 +522,95 @@ bool QObjectSerializer::fromJson(const QJsonObject &json, QObject *object, QObje
     if (interface != nullptr)
         interface->prepareForDeserialization();
 
-    QStack<const QMetaObject *> metaObjects;
-    QStringList classNames;
-    const QMetaObject *mo = object->metaObject();
-    while (mo) {
-        metaObjects.push(mo);
-        if (interface != nullptr && interface->canSerialize(mo, QMetaProperty()) == false) {
-            mo = mo->superClass();
+    const SerializationPlanPtr plan = ::ThePlans()->plan(object->metaObject());
+
+    for (const SerializationPlan::Property &planProp : plan->properties) {
+        const QMetaProperty &prop = planProp.property;
+        if (interface != nullptr && interface->canSerialize(planProp.metaObject, prop) == false)
             continue;
-        }
 
-        classNames << QString::fromLatin1(mo->className());
-        mo = mo->superClass();
-    }
+        const QString &propName = planProp.key;
+        const QJsonObject::const_iterator jsonIt = json.constFind(propName);
+        if (jsonIt == json.constEnd())
+            continue;
 
-    while (!metaObjects.isEmpty()) {
-        mo = metaObjects.pop();
+        const QJsonValue jsonPropValue = jsonIt.value();
 
-        const int nrProperties = mo->propertyCount();
-        for (int i = mo->propertyOffset(); i < nrProperties; i++) {
-            const QMetaProperty prop = mo->property(i);
-            if (interface != nullptr && interface->canSerialize(mo, prop) == false)
-                continue;
+        switch (planProp.kind) {
+        case SerializationPlan::ListProperty: {
+            const QJsonArray list = jsonPropValue.toArray();
 
-            const QMetaType propType(prop.userType());
+            QQmlListReference listRef(const_cast<QObject *>(object), prop.name());
+            const bool canAddObjects = interface
+                    && interface->canSetPropertyFromObjectList(propName) && listRef.canAppend();
 
-            static const char *objectName = "objectName";
-            if (!qstrcmp(prop.name(), objectName))
-                continue;
-
-            if (!prop.isStored())
-                continue;
+            QObjectFactory listItemFactory;
+            const QByteArray className(listRef.listElementType()->className());
+            listItemFactory.add(listRef.listElementType());
 
-            const bool isQObjectPointer = (propType.flags() & QMetaType::PointerToQObject);
-            const bool isQQmlListProperty =
-                    QByteArray(prop.typeName()).startsWith("QQmlListProperty");
-            if (!prop.isWritable() && !isQObjectPointer && !isQQmlListProperty)
-                continue;
+            QList<QObject *> propertyObjects;
+            if (canAddObjects)
+                propertyObjects.reserve(list.size());
+            else if (listRef.canAppend())
+                listRef.clear();
 
-            const QString propName = QString::fromLatin1(prop.name());
-            if (!json.contains(propName))
-                continue;
+            for (int i = 0; i < list.size(); i++) {
+                const QJsonObject listItem = list.at(i).toObject();
 
-            const QJsonValue jsonPropValue = json.value(propName);
-
-            if (isQQmlListProperty) {
-                const QJsonArray list = jsonPropValue.toArray();
-
-                QQmlListReference listRef(const_cast<QObject *>(object), prop.name());
-                const bool canAddObjects =
-                        interface && interface->canSetPropertyFromObjectList(propName)
-                        && listRef.canAppend();
-
-                QObjectFactory listItemFactory;
-                const QByteArray className(listRef.listElementType()->className());
-                listItemFactory.add(listRef.listElementType());
-
-                QList<QObject *> propertyObjects;
-                if (canAddObjects)
-                    propertyObjects.reserve(list.size());
-                else if (listRef.canAppend())
-                    listRef.clear();
-
-                for (int i = 0; i < list.size(); i++) {
-                    const QJsonObject listItem = list.at(i).toObject();
-
-                    if (listRef.canAppend()) {
-                        QObject *listItemObject =
-                                listItemFactory.create(className, listRef.object());
-                        QObjectSerializer::fromJson(listItem, listItemObject, factory);
-                        if (canAddObjects)
-                            propertyObjects.append(listItemObject);
-                        else
-                            listRef.append(listItemObject);
-                    } else {
-                        QObject *listItemObject = listRef.at(i);
-                        if (listItemObject == nullptr)
-                            continue;
-                        QObjectSerializer::fromJson(listItem, listItemObject, factory);
-                    }
+                if (listRef.canAppend()) {
+                    QObject *listItemObject = listItemFactory.create(className, listRef.object());
+                    QObjectSerializer::fromJson(listItem, listItemObject, factory);
+                    if (canAddObjects)
+                        propertyObjects.append(listItemObject);
+                    else
+                        listRef.append(listItemObject);
+                } else {
+                    QObject *listItemObject = listRef.at(i);
+                    if (listItemObject == nullptr)
+                        continue;
+                    QObjectSerializer::fromJson(listItem, listItemObject, factory);
                 }
-
-                if (canAddObjects)
-                    interface->setPropertyFromObjectList(propName, propertyObjects);
-
-                continue;
             }
 
-            if (prop.isEnumType() || prop.isFlagType()) {
-                const QByteArray key = jsonPropValue.toString().toLatin1();
-                const QMetaEnum enumerator = prop.enumerator();
-                const int value = prop.isFlagType()
-                        ? (key.isEmpty() ? 0 : enumerator.keysToValue(key))
-                        : enumerator.keyToValue(key);
-                prop.write(object, value);
-                continue;
-            }
+            if (canAddObjects)
+                interface->setPropertyFromObjectList(propName, propertyObjects);
+        } break;
+        case SerializationPlan::EnumProperty: {
+            const QByteArray key = jsonPropValue.toString().toLatin1();
+            const QMetaEnum enumerator = prop.enumerator();
+            const int value = prop.isFlagType()
+                    ? (key.isEmpty() ? 0 : enumerator.keysToValue(key))
+                    : enumerator.keyToValue(key);
+            prop.write(object, value);
+        } break;
+        case SerializationPlan::ObjectProperty: {
+            QObjectFactory *usableFactory = factory;
+            QObjectFactory stopGapFactory;
 
-            if (propType.flags() & QMetaType::PointerToQObject) {
-                QObjectFactory *usableFactory = factory;
-                QObjectFactory stopGapFactory;
-
-                const QVariant propValue = prop.read(object);
-                QObject *propObject = propValue.value<QObject *>();
-                if (propObject == nullptr) {
-                    if (factory == nullptr) {
-                        stopGapFactory.add(QMetaType::metaObjectForType(prop.userType()));
-                        usableFactory = &stopGapFactory;
-                    } else
-                        factory->add(QMetaType::metaObjectForType(prop.userType()));
-
-                    if (prop.isWritable() && usableFactory != nullptr) {
-                        const QByteArray className = QByteArray(prop.typeName()).replace('*', "");
-                        propObject = usableFactory->create(className, object);
-                        if (propObject == nullptr)
-                            continue;
-
-                        prop.write(object, QVariant::fromValue(propObject));
-                    } else
+            const QVariant propValue = prop.read(object);
+            QObject *propObject = propValue.value<QObject *>();
+            if (propObject == nullptr) {
+                if (factory == nullptr) {
+                    stopGapFactory.add(QMetaType::metaObjectForType(prop.userType()));
+                    usableFactory = &stopGapFactory;
+                } else
+                    factory->add(QMetaType::metaObjectForType(prop.userType()));
+
+                if (prop.isWritable() && usableFactory != nullptr) {
+                    const QByteArray className = QByteArray(prop.typeName()).replace('*', "");
+                    propObject = usableFactory->create(className, object);
+                    if (propObject == nullptr)
                         continue;
-                }
 
-                const QJsonObject propJson = jsonPropValue.toObject();
-                QObjectSerializer::fromJson(propJson, propObject, usableFactory);
-                continue;
+                    prop.write(object, QVariant::fromValue(propObject));
+                } else
+                    continue;
             }
 
+            const QJsonObject propJson = jsonPropValue.toObject();
+            QObjectSerializer::fromJson(propJson, propObject, usableFactory);
+        } break;
+        case SerializationPlan::ValueProperty: {
             switch (prop.userType()) {
             case QMetaType::QJsonValue:
                 prop.write(object, QVariant::fromValue<QJsonValue>(jsonPropValue));
@@ -470,12 +625,11 @@ bool QObjectSerializer::fromJson(const QJsonObject &json, QObject *object, QObje
                 break;
             }
 
-            const QObjectSerializer::Helper *helper = ::Helpers()->findHelper(prop.userType());
-            const QJsonValue propJsonValue = json.value(propName);
-            const QVariant propValue = helper == nullptr
-                    ? propJsonValue.toVariant()
-                    : helper->fromJson(propJsonValue, prop.userType());
+            const QVariant propValue = planProp.helper == nullptr
+                    ? jsonPropValue.toVariant()
+                    : planProp.helper->fromJson(jsonPropValue, prop.userType());
             prop.write(object, propValue);
+        } break;
         }
     }
 
@@ -883,15 +1037,13 @@ QVariant QRectFHelper::fromJson(const QJsonValue &value, int type) const
 
 QVariantMap QObjectSerializer::cacheDefaultPropertyValues(const QObject *object, bool readonly)
 {
-    static QMap<QByteArray, QVariantMap> defaultPropertyValueMap;
-
     QVariantMap ret;
     if (object == nullptr)
         return ret;
 
     const QByteArray className(object->metaObject()->className());
-    if (defaultPropertyValueMap.contains(className) || readonly)
-        return defaultPropertyValueMap.value(className);
+    if (readonly || ::ThePlans()->hasDefaultPropertyValues(className))
+        return ::ThePlans()->defaultPropertyValues(className);
 
     QObjectSerializer::Interface *interface = qobject_cast<QObjectSerializer::Interface *>(object);
 
@@ -957,7 +1109,7 @@ QVariantMap QObjectSerializer::cacheDefaultPropertyValues(const QObject *object,
         }
     }
 
-    defaultPropertyValueMap.insert(className, ret);
+    ::ThePlans()->setDefaultPropertyValues(className, ret);
 
     return ret;
 }
@@ -20,6 +20,7 @@
 #include <QJsonArray>
 #include <QJsonObject>
 
+#include "modifiable.h"
 #include "qobjectfactory.h"
 
 namespace QObjectSerializer {
@@ -43,6 +44,11 @@ public:
     virtual void serializeToJson(QJsonObject &) const { }
     virtual void deserializeFromJson(const QJsonObject &) { }
 
+    // Objects that mark themselves as modified whenever any of their serialized
+    // state changes can return themselves here. toJson() then reuses JSON produced
+    // earlier for the object, until its modification time changes.
+    virtual const Modifiable *serializationCacheKey() const { return nullptr; }
+
     virtual bool canSetPropertyFromObjectList(const QString & /*propName*/) const { return false; }
     virtual void setPropertyFromObjectList(const QString & /*propName*/,
                                            const QList<QObject *> & /*objects*/)
@@ -0,0 +1,13 @@
+QT += core
+DESTDIR = $$PWD/../../../Release/
+TARGET = graphlayoutbench
+CONFIG += console
+
+INCLUDEPATH += $$PWD/../../src/utils
+
+HEADERS += \
+    $$PWD/../../src/utils/graphlayout.h
+
+SOURCES += \
+    main.cpp \
+    $$PWD/../../src/utils/graphlayout.cpp
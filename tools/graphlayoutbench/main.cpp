@@ -0,0 +1,164 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include <QtCore>
+
+#include "graphlayout.h"
+
+/**
+ * Compares time taken by ForceDirectedLayout (which is what Scrite always used to lay out
+ * character relationship graphs) and BarnesHutLayout to lay out synthetic graphs of 50
+ * nodes and up. Every node in a graph is related to the one before it, and to a few others
+ * picked at random, much like characters in an ensemble cast.
+ *
+ * Both layouts run for the same number of iterations, unless they converge earlier. Both
+ * also scale the graph such that its closest nodes are a fixed distance apart. Mean length
+ * of edges in units of that distance tells whether both arrived at similar layouts.
+ *
+ *     graphlayoutbench --nodes 50,100,200,500,1000,2000 --iterations 50
+ */
+
+class Node : public GraphLayout::AbstractNode
+{
+public:
+    QSizeF size() const { return QSizeF(100, 100); }
+
+protected:
+    void move(const QPointF &) { }
+};
+
+class Edge : public GraphLayout::AbstractEdge
+{
+public:
+    Edge(Node *n1, Node *n2) : m_node1(n1), m_node2(n2) { }
+
+    GraphLayout::AbstractNode *node1() const { return m_node1; }
+    GraphLayout::AbstractNode *node2() const { return m_node2; }
+    void evaluateEdge() { }
+
+private:
+    Node *m_node1 = nullptr;
+    Node *m_node2 = nullptr;
+};
+
+static GraphLayout::Graph createGraph(int nrNodes, int nrEdgesPerNode)
+{
+    QRandomGenerator random(nrNodes);
+
+    GraphLayout::Graph graph;
+    for (int i = 0; i < nrNodes; i++) {
+        Node *node = new Node;
+        graph.nodes.append(node);
+
+        if (i == 0)
+            continue;
+
+        Node *previous = static_cast<Node *>(graph.nodes.at(i - 1));
+        graph.edges.append(new Edge(previous, node));
+
+        for (int j = 1; j < nrEdgesPerNode && i > 1; j++) {
+            Node *other = static_cast<Node *>(graph.nodes.at(random.bounded(i - 1)));
+            graph.edges.append(new Edge(other, node));
+        }
+    }
+
+    return graph;
+}
+
+static void deleteGraph(GraphLayout::Graph &graph)
+{
+    qDeleteAll(graph.edges);
+    qDeleteAll(graph.nodes);
+    graph.edges.clear();
+    graph.nodes.clear();
+}
+
+static qreal meanEdgeLength(const GraphLayout::Graph &graph)
+{
+    qreal ret = 0;
+    for (const GraphLayout::AbstractEdge *edge : graph.edges)
+        ret += QLineF(edge->node1()->position(), edge->node2()->position()).length();
+
+    return graph.edges.isEmpty() ? 0 : ret / graph.edges.size();
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+
+    QCommandLineOption nodesOption("nodes",
+                                   "Comma separated list of graph sizes, default is "
+                                   "50,100,200,500,1000,2000",
+                                   "counts", QStringLiteral("50,100,200,500,1000,2000"));
+    parser.addOption(nodesOption);
+
+    QCommandLineOption edgesOption("edges", "Number of edges per node, default is 3", "count",
+                                   QStringLiteral("3"));
+    parser.addOption(edgesOption);
+
+    QCommandLineOption iterationsOption("iterations", "Number of iterations, default is 50",
+                                        "count", QStringLiteral("50"));
+    parser.addOption(iterationsOption);
+
+    QCommandLineOption thetaOption("theta", "Theta of BarnesHutLayout, default is 0.5", "value",
+                                   QStringLiteral("0.5"));
+    parser.addOption(thetaOption);
+
+    parser.addHelpOption();
+    parser.process(a);
+
+    const int nrEdgesPerNode = qMax(1, parser.value(edgesOption).toInt());
+    const int nrIterations = qMax(1, parser.value(iterationsOption).toInt());
+    const qreal theta = parser.value(thetaOption).toDouble();
+
+    QTextStream ts(stdout);
+    ts << "Layout, Nodes, Edges, Time (ms), Time per iteration (ms), Mean edge length\n";
+
+    auto run = [&](GraphLayout::AbstractLayout *layout, const QString &name, int nrNodes) {
+        GraphLayout::Graph graph = createGraph(nrNodes, nrEdgesPerNode);
+
+        layout->setMaxTime(INT_MAX);
+        layout->setMaxIterations(nrIterations);
+        layout->setMinimumEdgeLength(100);
+
+        QElapsedTimer timer;
+        timer.start();
+        layout->layout(graph);
+        const qint64 time = timer.elapsed();
+
+        // Distance between closest nodes, as the layouts compute it for these node sizes
+        const qreal spacing = 100 + QLineF(QPointF(0, 0), QPointF(100, 100)).length();
+
+        ts << name << ", " << nrNodes << ", " << graph.edges.size() << ", " << time << ", "
+           << qreal(time) / nrIterations << ", " << meanEdgeLength(graph) / spacing << "\n";
+        ts.flush();
+
+        deleteGraph(graph);
+    };
+
+    const QStringList nodeCounts = parser.value(nodesOption).split(',', Qt::SkipEmptyParts);
+    for (const QString &nodeCount : nodeCounts) {
+        const int nrNodes = qMax(2, nodeCount.trimmed().toInt());
+
+        GraphLayout::ForceDirectedLayout forceDirectedLayout;
+        run(&forceDirectedLayout, QStringLiteral("ForceDirected"), nrNodes);
+
+        GraphLayout::BarnesHutLayout barnesHutLayout;
+        barnesHutLayout.setTheta(theta);
+        run(&barnesHutLayout, QStringLiteral("BarnesHut"), nrNodes);
+    }
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+QT += core
+DESTDIR = $$PWD/../../../Release/
+TARGET = headerbench
+CONFIG += console
+
+INCLUDEPATH += $$PWD/../../src/document
+
+HEADERS += \
+    $$PWD/../../src/document/documentheadercodec.h
+
+SOURCES += \
+    main.cpp \
+    $$PWD/../../src/document/documentheadercodec.cpp
@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include <QtCore>
+
+#include "documentheadercodec.h"
+
+/**
+ * Compares time taken to serialize and parse a Scrite document header, along with the
+ * size of the resulting header, when stored as indented JSON (which is what Scrite has
+ * always used) versus a compact binary CBOR encoding (see DocumentHeaderCodec).
+ *
+ * Debug builds of Scrite write the header of every document they save or open into a
+ * .json file next to it. Pass such a file to this program.
+ *
+ *     headerbench --header "Screenplay.json" --iterations 20
+ */
+
+static QByteArray encodeBinaryHeader(const QJsonObject &header)
+{
+    return DocumentHeaderCodec::encode(header, DocumentHeaderCodec::BinaryFormat);
+}
+
+struct Measurement
+{
+    QString name;
+    qint64 size = 0;
+    qint64 serializeTime = 0; // in microseconds
+    qint64 parseTime = 0; // in microseconds
+};
+
+template<class Serializer, class Parser>
+static Measurement measure(const QString &name, const QJsonObject &header, int iterations,
+                           Serializer serialize, Parser parse)
+{
+    Measurement ret;
+    ret.name = name;
+
+    QElapsedTimer timer;
+    QByteArray bytes;
+
+    timer.start();
+    for (int i = 0; i < iterations; i++)
+        bytes = serialize(header);
+    ret.serializeTime = timer.nsecsElapsed() / (1000 * qint64(iterations));
+    ret.size = bytes.size();
+
+    timer.restart();
+    for (int i = 0; i < iterations; i++) {
+        const QJsonObject parsed = parse(bytes);
+        if (parsed.isEmpty())
+            qWarning("%s: parsed header is empty.", qPrintable(name));
+    }
+    ret.parseTime = timer.nsecsElapsed() / (1000 * qint64(iterations));
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+
+    QCommandLineOption headerFileOption("header", "JSON file containing a Scrite document header",
+                                        "header-file");
+    parser.addOption(headerFileOption);
+
+    QCommandLineOption iterationsOption("iterations", "Number of iterations, default is 10",
+                                        "count", QStringLiteral("10"));
+    parser.addOption(iterationsOption);
+
+    parser.addHelpOption();
+    parser.process(a);
+
+    QFile headerFile(parser.value(headerFileOption));
+    if (!headerFile.open(QFile::ReadOnly)) {
+        qWarning("Could not open header file '%s'", qPrintable(headerFile.fileName()));
+        return -1;
+    }
+
+    const QJsonObject header = QJsonDocument::fromJson(headerFile.readAll()).object();
+    if (header.isEmpty()) {
+        qWarning("'%s' is not a JSON object", qPrintable(headerFile.fileName()));
+        return -1;
+    }
+
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+
+    QList<Measurement> measurements;
+    measurements << measure(
+            QStringLiteral("JSON (indented)"), header, iterations,
+            [](const QJsonObject &json) { return QJsonDocument(json).toJson(); },
+            [](const QByteArray &bytes) { return QJsonDocument::fromJson(bytes).object(); });
+    measurements << measure(
+            QStringLiteral("JSON (compact)"), header, iterations,
+            [](const QJsonObject &json) {
+                return QJsonDocument(json).toJson(QJsonDocument::Compact);
+            },
+            [](const QByteArray &bytes) { return QJsonDocument::fromJson(bytes).object(); });
+    measurements << measure(QStringLiteral("CBOR"), header, iterations, encodeBinaryHeader,
+                            DocumentHeaderCodec::decode);
+
+    QTextStream ts(stdout);
+    ts << "Format, Size (bytes), Serialize (us), Parse (us)\n";
+    for (const Measurement &m : qAsConst(measurements))
+        ts << m.name << ", " << m.size << ", " << m.serializeTime << ", " << m.parseTime << "\n";
+
+    return 0;
+}
@@ -0,0 +1,369 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QImage>
+#include <QPainter>
+#include <QPrinter>
+#include <QPicture>
+#include <QTextCursor>
+#include <QApplication>
+#include <QTextDocument>
+#include <QTextObjectInterface>
+#include <QAbstractTextDocumentLayout>
+
+#include "qtextdocumentpagerecorder.h"
+
+/**
+ * Measures pages per second printed into a PDF file through QPrinter, the way PdfExporter
+ * prints screenplays. Pages are either painted one after the other on the main thread
+ * (which is what Scrite always did), or recorded by QTextDocumentPageRecorder on 1, 2, 4 ...
+ * up to --threads worker threads and replayed onto the printer.
+ *
+ * The document is a paginated QTextDocument with screenplay-like paragraphs, and scene
+ * numbers drawn by an object handler. Headers, footers, watermarks and scene icons are not
+ * painted, only page contents are.
+ *
+ * With --verify, pages are painted onto images at printer resolution instead, once directly
+ * and once recorded on --threads worker threads, and the number of pixels that differ
+ * between the two is reported.
+ *
+ *     pdfbench --pages 150 --threads 8
+ *     pdfbench --pages 150 -platform offscreen
+ *     pdfbench --pages 40 --verify -platform offscreen
+ */
+
+class SceneNumberObject : public QObject, public QTextObjectInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(QTextObjectInterface)
+
+public:
+    enum { Type = QTextFormat::UserObject + 1, NumberProperty = QTextFormat::UserProperty + 1 };
+
+    SceneNumberObject(QObject *parent = nullptr) : QObject(parent)
+    {
+        this->setProperty("#threadSafeDrawing", true);
+    }
+
+    // QTextObjectInterface interface
+    QSizeF intrinsicSize(QTextDocument *doc, int posInDocument, const QTextFormat &format)
+    {
+        Q_UNUSED(doc)
+        Q_UNUSED(posInDocument)
+        Q_UNUSED(format)
+        return QSizeF(0, 12);
+    }
+
+    // Drawn the way ScreenplayTextObjectInterface draws scene numbers, to the left of the
+    // scene heading.
+    void drawObject(QPainter *painter, const QRectF &rect, QTextDocument *doc,
+                    int posInDocument, const QTextFormat &format)
+    {
+        Q_UNUSED(posInDocument)
+
+        const QString text = format.property(NumberProperty).toString() + QStringLiteral(".");
+        const QSizeF scale = QTextDocumentPageRecorder::textScale(doc, painter->device());
+
+        painter->save();
+        painter->translate(rect.left() - 48, rect.bottom());
+        painter->scale(scale.width(), scale.height());
+        painter->drawText(0, 0, text);
+        painter->restore();
+    }
+};
+
+static void populate(QTextDocument *document, int nrPages)
+{
+    QFont font(QStringLiteral("Courier Prime"), 12);
+    font.setStyleHint(QFont::Courier);
+
+    document->setDefaultFont(font);
+    document->setUseDesignMetrics(true);
+    document->setPageSize(QSizeF(612, 792)); // US Letter, in points
+    document->setDocumentMargin(72);
+
+    QTextBlockFormat headingFormat;
+    headingFormat.setTopMargin(24);
+
+    QTextBlockFormat actionFormat;
+    actionFormat.setTopMargin(12);
+
+    QTextBlockFormat characterFormat;
+    characterFormat.setTopMargin(12);
+    characterFormat.setLeftMargin(190);
+
+    QTextBlockFormat dialogueFormat;
+    dialogueFormat.setLeftMargin(100);
+    dialogueFormat.setRightMargin(110);
+
+    QTextCharFormat boldFormat;
+    boldFormat.setFontWeight(QFont::Bold);
+
+    QTextCharFormat sceneNumberFormat;
+    sceneNumberFormat.setObjectType(SceneNumberObject::Type);
+
+    const QString action = QStringLiteral(
+            "The rain hammers against the windows of the old apartment. She doesn't look up "
+            "from her laptop, typing furiously, as somewhere down the corridor a door slams.");
+    const QString dialogue = QStringLiteral(
+            "I told you we should have left before midnight, but you never listen. Nobody "
+            "leaves this room until I find out who took the keys.");
+
+    QTextCursor cursor(document);
+    for (int scene = 1; document->pageCount() < nrPages; scene++) {
+        for (int i = 0; i < 10; i++) {
+            if (!cursor.atStart())
+                cursor.insertBlock();
+
+            switch (i % 5) {
+            case 0:
+                cursor.setBlockFormat(i ? actionFormat : headingFormat);
+                if (i)
+                    cursor.insertText(action);
+                else {
+                    sceneNumberFormat.setProperty(SceneNumberObject::NumberProperty, scene);
+                    cursor.insertText(QString(QChar::ObjectReplacementCharacter),
+                                      sceneNumberFormat);
+                    cursor.insertText(QStringLiteral("INT. APARTMENT %1 - NIGHT").arg(scene),
+                                      boldFormat);
+                }
+                break;
+            case 1:
+            case 3:
+                cursor.setBlockFormat(characterFormat);
+                cursor.insertText(i == 1 ? QStringLiteral("ANNA") : QStringLiteral("MARK"));
+                break;
+            default:
+                cursor.setBlockFormat(dialogueFormat);
+                cursor.insertText(dialogue);
+                break;
+            }
+        }
+    }
+}
+
+static qint64 printSerially(const QTextDocument *document, const QString &fileName)
+{
+    QPrinter printer;
+    printer.setOutputFormat(QPrinter::PdfFormat);
+    printer.setOutputFileName(fileName);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QRectF body(QPointF(0, 0), document->pageSize());
+    const int pageCount = document->pageCount();
+
+    QPainter painter(&printer);
+    for (int pageNr = 1; pageNr <= pageCount; pageNr++) {
+        painter.save();
+        painter.scale(printer.width() / body.width(), printer.height() / body.height());
+        QTextDocumentPageRecorder::paintPage(&painter, document, pageNr, body);
+        painter.restore();
+
+        if (pageNr < pageCount)
+            printer.newPage();
+    }
+    painter.end();
+
+    return timer.elapsed();
+}
+
+static qint64 printRecorded(const QTextDocument *document, const QString &fileName,
+                            int nrThreads)
+{
+    QPrinter printer;
+    printer.setOutputFormat(QPrinter::PdfFormat);
+    printer.setOutputFileName(fileName);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QRectF body(QPointF(0, 0), document->pageSize());
+    const int pageCount = document->pageCount();
+
+    QTextDocumentPageRecorder recorder(document, body);
+    recorder.setMaxThreadCount(nrThreads);
+    recorder.setMinPagesPerThread(1);
+    if (!recorder.start())
+        qWarning("Pages are not being recorded.");
+
+    QPainter painter(&printer);
+    for (int pageNr = 1; pageNr <= pageCount; pageNr++) {
+        painter.save();
+        painter.scale(printer.width() / body.width(), printer.height() / body.height());
+
+        QPicture page;
+        if (recorder.takePage(pageNr, &page))
+            painter.drawPicture(0, 0, page);
+        else
+            QTextDocumentPageRecorder::paintPage(&painter, document, pageNr, body);
+        painter.restore();
+
+        if (pageNr < pageCount)
+            printer.newPage();
+    }
+    painter.end();
+
+    return timer.elapsed();
+}
+
+// Images stand in for printers, whose resolution is a multiple of the default one.
+static const int VerifyScale = 3;
+
+static QImage createPageImage(const QTextDocument *document)
+{
+    QImage image((document->pageSize() * VerifyScale).toSize(), QImage::Format_ARGB32);
+    image.setDotsPerMeterX(image.dotsPerMeterX() * VerifyScale);
+    image.setDotsPerMeterY(image.dotsPerMeterY() * VerifyScale);
+    image.fill(Qt::white);
+    return image;
+}
+
+static int countDifferentPixels(const QImage &image1, const QImage &image2)
+{
+    int count = 0;
+    for (int y = 0; y < image1.height(); y++) {
+        const QRgb *line1 = reinterpret_cast<const QRgb *>(image1.constScanLine(y));
+        const QRgb *line2 = reinterpret_cast<const QRgb *>(image2.constScanLine(y));
+        for (int x = 0; x < image1.width(); x++) {
+            if (line1[x] != line2[x])
+                ++count;
+        }
+    }
+
+    return count;
+}
+
+// Paints every page directly and from pages recorded on nrThreads threads, and compares
+// the two. Text drawn by object handlers is where the two are most likely to differ, since
+// the handler paints onto a QPicture while recording.
+static void verify(const QTextDocument *document, int nrThreads, QTextStream &ts)
+{
+    const QRectF body(QPointF(0, 0), document->pageSize());
+    const int pageCount = document->pageCount();
+
+    const QImage blankPage = createPageImage(document);
+
+    QTextDocumentPageRecorder recorder(document, body);
+    recorder.setMaxThreadCount(nrThreads);
+    recorder.setMinPagesPerThread(1);
+    recorder.setTargetDevice(&blankPage);
+    if (!recorder.start())
+        qWarning("Pages are not being recorded.");
+
+    int nrRecordedPages = 0;
+    int nrDifferentPages = 0;
+    qreal worstDifference = 0;
+
+    for (int pageNr = 1; pageNr <= pageCount; pageNr++) {
+        QImage paintedPage = blankPage;
+        QPainter painter(&paintedPage);
+        painter.scale(VerifyScale, VerifyScale);
+        QTextDocumentPageRecorder::paintPage(&painter, document, pageNr, body);
+        painter.end();
+
+        QPicture page;
+        if (!recorder.takePage(pageNr, &page))
+            continue;
+
+        QImage recordedPage = blankPage;
+        painter.begin(&recordedPage);
+        painter.scale(VerifyScale, VerifyScale);
+        painter.drawPicture(0, 0, page);
+        painter.end();
+
+        ++nrRecordedPages;
+
+        const int nrDifferentPixels = ::countDifferentPixels(paintedPage, recordedPage);
+        if (nrDifferentPixels > 0) {
+            ++nrDifferentPages;
+            worstDifference = qMax(worstDifference,
+                                   qreal(nrDifferentPixels) * 100
+                                           / (paintedPage.width() * paintedPage.height()));
+        }
+    }
+
+    ts << "Threads, Pages, Recorded Pages, Different Pages, Worst Difference (% pixels)\n";
+    ts << nrThreads << ", " << pageCount << ", " << nrRecordedPages << ", " << nrDifferentPages
+       << ", " << worstDifference << "\n";
+    ts.flush();
+}
+
+int main(int argc, char **argv)
+{
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+
+    QCommandLineOption pagesOption("pages", "Number of pages, default is 150", "count",
+                                   QStringLiteral("150"));
+    parser.addOption(pagesOption);
+
+    QCommandLineOption threadsOption("threads",
+                                     "Largest number of threads to try, default is the number "
+                                     "of cores",
+                                     "count", QString::number(QThread::idealThreadCount()));
+    parser.addOption(threadsOption);
+
+    QCommandLineOption verifyOption("verify",
+                                    "Compare recorded pages with pages painted directly, instead "
+                                    "of measuring speed");
+    parser.addOption(verifyOption);
+
+    parser.addHelpOption();
+    parser.process(a);
+
+    SceneNumberObject sceneNumberObject;
+
+    QTextDocument document;
+    document.documentLayout()->registerHandler(SceneNumberObject::Type, &sceneNumberObject);
+    populate(&document, qMax(1, parser.value(pagesOption).toInt()));
+
+    const int pageCount = document.pageCount();
+    const int maxThreads = qMax(1, parser.value(threadsOption).toInt());
+    const QString fileName = QDir::tempPath() + QStringLiteral("/scrite-pdfbench-")
+            + QString::number(QCoreApplication::applicationPid()) + QStringLiteral(".pdf");
+
+    QTextStream ts(stdout);
+    if (parser.isSet(verifyOption)) {
+        ::verify(&document, maxThreads, ts);
+        return 0;
+    }
+
+    ts << "Mode, Threads, Pages, Time (ms), Pages/sec\n";
+
+    auto report = [&](const QString &mode, int nrThreads, qint64 time) {
+        time = qMax(qint64(1), time);
+        ts << mode << ", " << nrThreads << ", " << pageCount << ", " << time << ", "
+           << (qint64(pageCount) * 1000) / time << "\n";
+        ts.flush();
+    };
+
+    report(QStringLiteral("Serial"), 1, printSerially(&document, fileName));
+
+    for (int nrThreads = 1;; nrThreads = qMin(nrThreads * 2, maxThreads)) {
+        report(QStringLiteral("Recorded"), nrThreads,
+               printRecorded(&document, fileName, nrThreads));
+
+        if (nrThreads == maxThreads)
+            break;
+    }
+
+    QFile::remove(fileName);
+
+    return 0;
+}
+
+#include "main.moc"
@@ -0,0 +1,13 @@
+QT += core gui widgets printsupport
+DESTDIR = $$PWD/../../../Release/
+TARGET = pdfbench
+CONFIG += console
+
+INCLUDEPATH += $$PWD/../../src/printing
+
+HEADERS += \
+    $$PWD/../../src/printing/qtextdocumentpagerecorder.h
+
+SOURCES += \
+    main.cpp \
+    $$PWD/../../src/printing/qtextdocumentpagerecorder.cpp
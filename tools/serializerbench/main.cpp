@@ -0,0 +1,204 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtQml>
+#include <QColor>
+
+#include "qobjectserializer.h"
+
+/**
+ * Measures time taken by QObjectSerializer::toJson() and QObjectSerializer::fromJson() over
+ * a document shaped like a typical screenplay: a number of scenes, each with a handful of
+ * properties and a list of paragraphs.
+ *
+ * The classes here mirror the serialized shape of Scene and SceneElement, without pulling
+ * in the rest of Scrite. Paragraphs don't opt into the serialization cache, so every run
+ * walks every property of every object.
+ *
+ *     serializerbench --scenes 200 --paragraphs 25 --iterations 20
+ */
+
+class BenchParagraph : public QObject
+{
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE explicit BenchParagraph(QObject *parent = nullptr) : QObject(parent) { }
+    ~BenchParagraph() { }
+
+    enum Type { Action, Character, Dialogue, Parenthetical, Shot, Transition, Heading };
+    Q_ENUM(Type)
+
+    Q_PROPERTY(QString id MEMBER m_id)
+    Q_PROPERTY(Type type MEMBER m_type)
+    Q_PROPERTY(QString text MEMBER m_text)
+    Q_PROPERTY(Qt::Alignment alignment MEMBER m_alignment)
+    Q_PROPERTY(int cursorPosition MEMBER m_cursorPosition STORED false)
+    Q_PROPERTY(int wordCount READ wordCount CONSTANT)
+
+    int wordCount() const { return m_text.count(QLatin1Char(' ')) + 1; }
+
+    QString m_id;
+    Type m_type = Action;
+    QString m_text;
+    Qt::Alignment m_alignment;
+    int m_cursorPosition = -1;
+};
+
+class BenchScene : public QObject, public QObjectSerializer::Interface
+{
+    Q_OBJECT
+    Q_INTERFACES(QObjectSerializer::Interface)
+
+public:
+    Q_INVOKABLE explicit BenchScene(QObject *parent = nullptr) : QObject(parent) { }
+    ~BenchScene() { }
+
+    Q_PROPERTY(QString id MEMBER m_id)
+    Q_PROPERTY(QString title MEMBER m_title)
+    Q_PROPERTY(QString emotionalChange MEMBER m_emotionalChange)
+    Q_PROPERTY(QColor color MEMBER m_color)
+    Q_PROPERTY(bool enabled MEMBER m_enabled)
+    Q_PROPERTY(QStringList tags MEMBER m_tags)
+    Q_PROPERTY(QJsonObject characterRelationshipGraph MEMBER m_characterRelationshipGraph)
+
+    Q_PROPERTY(QQmlListProperty<BenchParagraph> elements READ elements)
+    QQmlListProperty<BenchParagraph> elements()
+    {
+        return QQmlListProperty<BenchParagraph>(this, &m_elements);
+    }
+
+    QString m_id;
+    QString m_title;
+    QString m_emotionalChange;
+    QColor m_color = Qt::white;
+    bool m_enabled = true;
+    QStringList m_tags;
+    QJsonObject m_characterRelationshipGraph;
+    QList<BenchParagraph *> m_elements;
+};
+
+class BenchDocument : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BenchDocument(QObject *parent = nullptr) : QObject(parent) { }
+    ~BenchDocument() { }
+
+    Q_PROPERTY(QString title MEMBER m_title)
+    Q_PROPERTY(QString author MEMBER m_author)
+
+    Q_PROPERTY(QQmlListProperty<BenchScene> scenes READ scenes)
+    QQmlListProperty<BenchScene> scenes() { return QQmlListProperty<BenchScene>(this, &m_scenes); }
+
+    QString m_title;
+    QString m_author;
+    QList<BenchScene *> m_scenes;
+};
+
+static void populate(BenchDocument *document, int nrScenes, int nrParagraphs)
+{
+    static const BenchParagraph::Type types[] = { BenchParagraph::Character,
+                                                  BenchParagraph::Parenthetical,
+                                                  BenchParagraph::Dialogue,
+                                                  BenchParagraph::Action };
+
+    document->m_title = QStringLiteral("Benchmark");
+    document->m_author = QStringLiteral("Scrite");
+
+    for (int i = 0; i < nrScenes; i++) {
+        BenchScene *scene = new BenchScene(document);
+        scene->m_id = QUuid::createUuid().toString();
+        scene->m_title = QStringLiteral("Scene %1 takes place somewhere in the city.").arg(i + 1);
+        scene->m_tags = QStringList { QStringLiteral("act-%1").arg(i / 50 + 1) };
+        document->m_scenes.append(scene);
+
+        for (int j = 0; j < nrParagraphs; j++) {
+            BenchParagraph *paragraph = new BenchParagraph(scene);
+            paragraph->m_id = QUuid::createUuid().toString();
+            paragraph->m_type = types[j % 4];
+            paragraph->m_text = QStringLiteral("Paragraph %1 of scene %2, with a few more words "
+                                               "to make it look like real dialogue.")
+                                        .arg(j + 1)
+                                        .arg(i + 1);
+            scene->m_elements.append(paragraph);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+
+    QCommandLineOption scenesOption("scenes", "Number of scenes, default is 200", "count",
+                                    QStringLiteral("200"));
+    parser.addOption(scenesOption);
+
+    QCommandLineOption paragraphsOption("paragraphs", "Paragraphs per scene, default is 25",
+                                        "count", QStringLiteral("25"));
+    parser.addOption(paragraphsOption);
+
+    QCommandLineOption iterationsOption("iterations", "Number of iterations, default is 10",
+                                        "count", QStringLiteral("10"));
+    parser.addOption(iterationsOption);
+
+    parser.addHelpOption();
+    parser.process(a);
+
+    // QQmlListReference can only resolve element types of lists known to QML.
+    qmlRegisterAnonymousType<BenchScene>("serializerbench", 1);
+    qmlRegisterAnonymousType<BenchParagraph>("serializerbench", 1);
+
+    const int nrScenes = qMax(1, parser.value(scenesOption).toInt());
+    const int nrParagraphs = qMax(1, parser.value(paragraphsOption).toInt());
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+
+    BenchDocument document;
+    populate(&document, nrScenes, nrParagraphs);
+
+    QElapsedTimer timer;
+    QJsonObject json;
+
+    // The first call also creates serialization plans, so we leave it out.
+    json = QObjectSerializer::toJson(&document);
+
+    timer.start();
+    for (int i = 0; i < iterations; i++)
+        json = QObjectSerializer::toJson(&document);
+    const qint64 toJsonTime = timer.nsecsElapsed() / (1000 * qint64(iterations));
+
+    qint64 fromJsonTime = 0;
+    for (int i = 0; i < iterations; i++) {
+        BenchDocument loaded;
+        timer.restart();
+        QObjectSerializer::fromJson(json, &loaded);
+        fromJsonTime += timer.nsecsElapsed() / 1000;
+
+        if (loaded.m_scenes.size() != nrScenes)
+            qWarning("Loaded %d scenes, expected %d.", loaded.m_scenes.size(), nrScenes);
+    }
+    fromJsonTime /= iterations;
+
+    QTextStream ts(stdout);
+    ts << "Scenes, Paragraphs, toJson (us), fromJson (us)\n";
+    ts << nrScenes << ", " << nrScenes * nrParagraphs << ", " << toJsonTime << ", "
+       << fromJsonTime << "\n";
+
+    return 0;
+}
+
+#include "main.moc"
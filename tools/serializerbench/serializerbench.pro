@@ -0,0 +1,14 @@
+QT += core gui widgets qml
+DESTDIR = $$PWD/../../../Release/
+TARGET = serializerbench
+CONFIG += console
+
+INCLUDEPATH += $$PWD/../../src/utils
+
+HEADERS += \
+    $$PWD/../../src/utils/qobjectserializer.h
+
+SOURCES += \
+    main.cpp \
+    $$PWD/../../src/utils/timeprofiler.cpp \
+    $$PWD/../../src/utils/qobjectserializer.cpp
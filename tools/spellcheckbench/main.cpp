@@ -0,0 +1,199 @@
+/****************************************************************************
+**
+** Copyright (C) VCreate Logic Pvt. Ltd. Bengaluru
+** Author: Prashanth N Udupa (prashanth@scrite.io)
+**
+** This code is distributed under GPL v3. Complete text of the license
+** can be found here: https://www.gnu.org/licenses/gpl-3.0.txt
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+#include <QtCore>
+#include <QtConcurrent>
+
+#include "loader_p.h"
+#include "textbreaks_p.h"
+#include "spellerplugin_p.h"
+
+/**
+ * Measures spell-check throughput of paragraphs, the way SpellCheckService checks them:
+ * each thread in a pool checks whole paragraphs with its own speller plugin.
+ *
+ * Paragraphs are checked with 1, 2, 4 ... up to --threads threads, so that the gain from
+ * adding threads can be read off one run. There is no verdict cache here, every word is
+ * looked up in the dictionary.
+ *
+ *     spellcheckbench --paragraphs 5000 --threads 8
+ *     spellcheckbench --file screenplay.txt
+ */
+
+static QString SpellCheckLanguage()
+{
+#ifdef Q_OS_MAC
+    return QStringLiteral("en");
+#else
+#ifdef Q_OS_WIN
+    return QString(); // default language
+#else
+    return QStringLiteral("en_US");
+#endif
+#endif
+}
+
+static Sonnet::SpellerPlugin *ThreadSpeller()
+{
+    static QMutex mutex;
+    static QThreadStorage<Sonnet::SpellerPlugin *> spellers;
+    if (!spellers.hasLocalData()) {
+        QMutexLocker locker(&mutex);
+        spellers.setLocalData(Sonnet::Loader::openLoader()->createSpeller(SpellCheckLanguage()));
+    }
+    return spellers.localData();
+}
+
+static int CountMisspelledWords(const QString &paragraph)
+{
+    Sonnet::SpellerPlugin *speller = ThreadSpeller();
+    if (speller == nullptr)
+        return 0;
+
+    int ret = 0;
+    const Sonnet::TextBreaks::Positions wordPositions = Sonnet::TextBreaks::wordBreaks(paragraph);
+    for (const Sonnet::TextBreaks::Position &wordPosition : wordPositions) {
+        const QString word = paragraph.mid(wordPosition.start, wordPosition.length);
+        if (!word.isEmpty() && speller->isMisspelled(word))
+            ++ret;
+    }
+
+    return ret;
+}
+
+static QStringList generateParagraphs(int count)
+{
+    static const QStringList sentences = {
+        QStringLiteral("The rain hammers against the windows of the old apartmnet."),
+        QStringLiteral("She doesn't look up from her laptop, typing furiously."),
+        QStringLiteral("I told you we should have left before midnight, but you never listen."),
+        QStringLiteral("A long beat. He picks up the phone and dials a number from memory."),
+        QStringLiteral("Somewhere down the corridor, a door slams and footsteps recede."),
+        QStringLiteral("We're going to need a bigger boat, and a much better excuse."),
+        QStringLiteral("The detective studies the photograph, her jaw tightening slowy."),
+        QStringLiteral("Nobody leaves this room until I find out who took the keys.")
+    };
+
+    QStringList ret;
+    ret.reserve(count);
+    for (int i = 0; i < count; i++) {
+        QStringList paragraph;
+        for (int j = 0; j < 1 + i % 4; j++)
+            paragraph << sentences.at((i + j * 3) % sentences.size());
+        ret << paragraph.join(QLatin1Char(' '));
+    }
+
+    return ret;
+}
+
+static QStringList loadParagraphs(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly))
+        return QStringList();
+
+    QStringList ret;
+    QTextStream ts(&file);
+    while (!ts.atEnd()) {
+        const QString line = ts.readLine().trimmed();
+        if (!line.isEmpty())
+            ret << line;
+    }
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+
+    QCommandLineOption paragraphsOption("paragraphs",
+                                        "Number of generated paragraphs, default is 5000",
+                                        "count", QStringLiteral("5000"));
+    parser.addOption(paragraphsOption);
+
+    QCommandLineOption fileOption("file", "Check non-empty lines of this text file instead",
+                                  "path");
+    parser.addOption(fileOption);
+
+    QCommandLineOption threadsOption("threads",
+                                     "Largest number of threads to try, default is the number "
+                                     "of cores",
+                                     "count", QString::number(QThread::idealThreadCount()));
+    parser.addOption(threadsOption);
+
+    parser.addHelpOption();
+    parser.process(a);
+
+    const QStringList paragraphs = parser.isSet(fileOption)
+            ? loadParagraphs(parser.value(fileOption))
+            : generateParagraphs(qMax(1, parser.value(paragraphsOption).toInt()));
+    if (paragraphs.isEmpty()) {
+        qWarning("Nothing to check.");
+        return 1;
+    }
+
+    if (Sonnet::Loader::openLoader() == nullptr) {
+        qWarning("Sonnet could not be loaded.");
+        return 1;
+    }
+
+    int nrWords = 0;
+    for (const QString &paragraph : paragraphs)
+        nrWords += Sonnet::TextBreaks::wordBreaks(paragraph).size();
+
+    const int maxThreads = qMax(1, parser.value(threadsOption).toInt());
+
+    QTextStream ts(stdout);
+    ts << "Threads, Paragraphs, Words, Misspelled, Time (ms), Words/sec\n";
+
+    for (int nrThreads = 1;; nrThreads = qMin(nrThreads * 2, maxThreads)) {
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(nrThreads);
+        threadPool.setExpiryTimeout(-1);
+
+        // Spellers load dictionaries when they are created, keep that out of the timing.
+        QVector<QFuture<void>> warmups;
+        for (int i = 0; i < nrThreads; i++)
+            warmups << QtConcurrent::run(&threadPool, []() {
+                ThreadSpeller();
+                QThread::msleep(50);
+            });
+        for (QFuture<void> &warmup : warmups)
+            warmup.waitForFinished();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        QVector<QFuture<int>> futures;
+        futures.reserve(paragraphs.size());
+        for (const QString &paragraph : paragraphs)
+            futures << QtConcurrent::run(&threadPool, CountMisspelledWords, paragraph);
+
+        int nrMisspelled = 0;
+        for (QFuture<int> &future : futures)
+            nrMisspelled += future.result();
+
+        const qint64 time = qMax(qint64(1), timer.elapsed());
+        ts << nrThreads << ", " << paragraphs.size() << ", " << nrWords << ", " << nrMisspelled
+           << ", " << time << ", " << (qint64(nrWords) * 1000) / time << "\n";
+        ts.flush();
+
+        if (nrThreads == maxThreads)
+            break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+QT += core concurrent
+DESTDIR = $$PWD/../../../Release/
+TARGET = spellcheckbench
+CONFIG += console
+
+include($$PWD/../../3rdparty/sonnet/sonnet.pri)
+
+# SpellCheckService needs the rest of Scrite, we only need Sonnet.
+SONNET_PATH = $$clean_path($$PWD/../../3rdparty/sonnet)
+HEADERS -= $$SONNET_PATH/spellcheckservice.h
+SOURCES -= $$SONNET_PATH/spellcheckservice.cpp
+
+SOURCES += \
+    main.cpp